@@ -0,0 +1,236 @@
+#include "batch_processor.h"
+#include "recipe.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+struct BatchJob
+{
+    BatchFileResult result;
+    Mat image;
+};
+
+static double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static bool isImageFile(const fs::path &path)
+{
+    static const vector<string> extensions = {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff", ".webp", ".pgm", ".ppm", ".pnm"};
+
+    string extension = path.extension().string();
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+bool collectBatchInputs(const string &source, vector<string> &inputPaths, string &error)
+{
+    error_code errorCode;
+
+    if (fs::is_directory(source, errorCode))
+    {
+        for (const fs::directory_entry &entry : fs::directory_iterator(source, errorCode))
+        {
+            if (entry.is_regular_file() && isImageFile(entry.path()))
+            {
+                inputPaths.push_back(entry.path().string());
+            }
+        }
+        sort(inputPaths.begin(), inputPaths.end());
+    }
+    else if (fs::is_regular_file(source, errorCode))
+    {
+        ifstream listFile(source);
+        string line;
+        while (getline(listFile, line))
+        {
+            // skip blank lines and comments
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == string::npos || line[first] == '#')
+                continue;
+            size_t last = line.find_last_not_of(" \t\r");
+            inputPaths.push_back(line.substr(first, last - first + 1));
+        }
+    }
+    else
+    {
+        error = source + " is neither a directory nor a list file";
+        return false;
+    }
+
+    if (errorCode)
+    {
+        error = source + ": " + errorCode.message();
+        return false;
+    }
+
+    return true;
+}
+
+BatchSummary runBatch(const vector<string> &inputPaths, const string &outputDirectory,
+                      const vector<ImageOperation> &operations, const BatchOptions &options,
+                      const function<void(const BatchFileResult &)> &onResult)
+{
+    auto batchStart = chrono::steady_clock::now();
+
+    int threadCount = options.threadCount > 0 ? options.threadCount : max(1, (int)thread::hardware_concurrency());
+    int decoderCount = max(1, threadCount / 4);
+    int encoderCount = max(1, threadCount / 4);
+    int processorCount = max(1, threadCount - decoderCount - encoderCount);
+    size_t capacity = options.queueCapacity > 0 ? options.queueCapacity : 2 * threadCount;
+    vector<RecipeStage> plan = planRecipe(operations);
+    BatchSummary summary;
+
+    // Two inputs with the same name (or extension after --format) would race for one output file
+    vector<string> outputPaths;
+    map<string, string> inputOfOutput;
+    for (const string &inputPath : inputPaths)
+    {
+        fs::path outputPath = fs::path(outputDirectory) / fs::path(inputPath).filename();
+        if (!options.outputExtension.empty())
+            outputPath.replace_extension(options.outputExtension);
+
+        auto inserted = inputOfOutput.emplace(outputPath.lexically_normal().string(), inputPath);
+        if (!inserted.second)
+        {
+            summary.error = inserted.first->second + " and " + inputPath + " would both be saved as " + outputPath.string();
+            return summary;
+        }
+        outputPaths.push_back(outputPath.string());
+    }
+
+    error_code errorCode;
+    fs::create_directories(outputDirectory, errorCode);
+    if (errorCode)
+    {
+        summary.error = outputDirectory + ": " + errorCode.message();
+        return summary;
+    }
+
+    BoundedQueue<BatchJob> decodedQueue(capacity);
+    BoundedQueue<BatchJob> processedQueue(capacity);
+    atomic<size_t> nextInput(0);
+    atomic<int> runningDecoders(decoderCount);
+    atomic<int> runningProcessors(processorCount);
+
+    mutex resultMutex;
+
+    auto report = [&](const BatchFileResult &result)
+    {
+        lock_guard<mutex> lock(resultMutex);
+        summary.files++;
+        if (result.succeeded)
+            summary.pixels += result.pixels;
+        else
+            summary.failed++;
+        if (onResult)
+            onResult(result);
+    };
+
+    auto decode = [&]()
+    {
+        size_t index;
+        while ((index = nextInput++) < inputPaths.size())
+        {
+            BatchJob job;
+            job.result.inputPath = inputPaths[index];
+            job.result.outputPath = outputPaths[index];
+
+            auto start = chrono::steady_clock::now();
+            job.image = imread(job.result.inputPath);
+            job.result.decodeMs = elapsedMs(start);
+
+            if (job.image.empty())
+            {
+                job.result.error = "failed to load the image";
+                report(job.result);
+                continue;
+            }
+
+            job.result.pixels = job.image.total();
+            decodedQueue.push(std::move(job));
+        }
+
+        if (--runningDecoders == 0)
+            decodedQueue.close();
+    };
+
+    auto process = [&]()
+    {
+        BatchJob job;
+        while (decodedQueue.pop(job))
+        {
+            auto start = chrono::steady_clock::now();
+            try
+            {
+                job.image = executePlan(job.image, plan);
+            }
+            catch (const cv::Exception &exception)
+            {
+                job.result.error = exception.what();
+                report(job.result);
+                continue;
+            }
+            job.result.processMs = elapsedMs(start);
+
+            processedQueue.push(std::move(job));
+        }
+
+        if (--runningProcessors == 0)
+            processedQueue.close();
+    };
+
+    auto encode = [&]()
+    {
+        BatchJob job;
+        while (processedQueue.pop(job))
+        {
+            auto start = chrono::steady_clock::now();
+            try
+            {
+                job.result.succeeded = imwrite(job.result.outputPath, job.image);
+                if (!job.result.succeeded)
+                    job.result.error = "failed to save the image";
+            }
+            catch (const cv::Exception &exception)
+            {
+                job.result.error = exception.what();
+            }
+            job.result.encodeMs = elapsedMs(start);
+            job.image.release();
+
+            report(job.result);
+        }
+    };
+
+    // With enough files every image gets its own core, OpenCV's own threads would only compete
+    int previousThreadCount = getNumThreads();
+    if (inputPaths.size() >= (size_t)processorCount)
+        setNumThreads(1);
+
+    vector<thread> workers;
+    for (int i = 0; i < decoderCount; i++)
+        workers.emplace_back(decode);
+    for (int i = 0; i < processorCount; i++)
+        workers.emplace_back(process);
+    for (int i = 0; i < encoderCount; i++)
+        workers.emplace_back(encode);
+
+    for (thread &worker : workers)
+        worker.join();
+
+    setNumThreads(previousThreadCount);
+
+    summary.seconds = elapsedMs(batchStart) / 1000.0;
+    return summary;
+}
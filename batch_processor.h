@@ -0,0 +1,106 @@
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include "image_operation.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Blocking queue with a fixed capacity, push waits while the queue is full so a fast stage
+// can't run ahead of a slow one and pile up decoded images.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity < 1 ? 1 : capacity) {}
+
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity || closed; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+};
+
+struct BatchOptions
+{
+    // 0 uses every core
+    int threadCount = 0;
+    // images waiting between two stages, 0 uses twice the thread count
+    int queueCapacity = 0;
+    // e.g. ".png", empty keeps the extension of the input
+    std::string outputExtension;
+};
+
+struct BatchFileResult
+{
+    std::string inputPath;
+    std::string outputPath;
+    bool succeeded = false;
+    std::string error;
+    double decodeMs = 0;
+    double processMs = 0;
+    double encodeMs = 0;
+    long long pixels = 0;
+};
+
+struct BatchSummary
+{
+    int files = 0;
+    int failed = 0;
+    double seconds = 0;
+    long long pixels = 0;
+    // set when the batch couldn't start, no file was processed
+    std::string error;
+};
+
+// Images of a directory, or the paths listed one per line in a text file
+bool collectBatchInputs(const std::string &source, std::vector<std::string> &inputPaths, std::string &error);
+
+// Decodes, processes (through the planned recipe) and encodes the inputs as three overlapping stages.
+// onResult is called once per file, serialized, from the worker threads. Fails before any file is
+// read when the output directory can't be created or two inputs map to the same output file.
+BatchSummary runBatch(const std::vector<std::string> &inputPaths, const std::string &outputDirectory,
+                      const std::vector<ImageOperation> &operations, const BatchOptions &options,
+                      const std::function<void(const BatchFileResult &)> &onResult);
+
+#endif // BATCH_PROCESSOR_H
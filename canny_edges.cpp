@@ -0,0 +1,217 @@
+#include "canny_edges.h"
+#include "sobel_gradient.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// The 5x5 derivatives of a step are 12 times those of the 3x3 Sobel kernels
+static const int gradientScale = 12;
+
+enum EdgeClass : uchar
+{
+    NotEdge = 0,
+    WeakEdge = 1,
+    StrongEdge = 255
+};
+
+// Bands of rows processed independently, a few per thread so uneven bands balance out
+static vector<Range> rowBands(int rows)
+{
+    int count = max(1, min(rows / 16, getNumThreads() * 4));
+    vector<Range> bands;
+    for (int i = 0; i < count; i++)
+    {
+        bands.emplace_back(rows * i / count, rows * (i + 1) / count);
+    }
+    return bands;
+}
+
+// Keeps the pixels whose magnitude is a maximum along the gradient direction, ties go to the
+// left/upper pixel so a ridge two pixels wide gives a single edge. magnitude is the squared L2
+// magnitude with a zero border of one pixel.
+static void suppressNonMaxima(const Mat &dx, const Mat &dy, const Mat &magnitude, Mat &edges, int lowSquared, int highSquared, const Range &rows)
+{
+    // tan(22.5) and tan(67.5) in 15 bit fixed point, |d| << 15 stays within int for 5x5 derivatives
+    const int tan22 = 13573;
+    const int tan67 = 79109;
+
+    for (int y = rows.start; y < rows.end; y++)
+    {
+        const int16_t *dxRow = dx.ptr<int16_t>(y);
+        const int16_t *dyRow = dy.ptr<int16_t>(y);
+        const int *above = magnitude.ptr<int>(y) + 1;
+        const int *centre = magnitude.ptr<int>(y + 1) + 1;
+        const int *below = magnitude.ptr<int>(y + 2) + 1;
+        uchar *edgeRow = edges.ptr<uchar>(y);
+
+        for (int x = 0; x < edges.cols; x++)
+        {
+            int m = centre[x];
+            edgeRow[x] = NotEdge;
+            if (m <= lowSquared)
+                continue;
+
+            int gx = dxRow[x];
+            int gy = dyRow[x];
+            int ax = abs(gx) * tan22;
+            int ay = abs(gy) << 15;
+            int first, second;
+
+            if (ay < ax)
+            {
+                // mostly horizontal gradient
+                first = centre[x - 1];
+                second = centre[x + 1];
+            }
+            else if (ay > abs(gx) * tan67)
+            {
+                first = above[x];
+                second = below[x];
+            }
+            else if ((gx ^ gy) >= 0)
+            {
+                // both derivatives of the same sign, the gradient points down and to the right
+                first = above[x - 1];
+                second = below[x + 1];
+            }
+            else
+            {
+                first = above[x + 1];
+                second = below[x - 1];
+            }
+
+            if (m > first && m >= second)
+                edgeRow[x] = m > highSquared ? StrongEdge : WeakEdge;
+        }
+    }
+}
+
+// Turns the seeds and the weak edges connected to them into strong edges without leaving the band
+static void growStrongEdges(Mat &edges, const Range &band, vector<Point> &seeds)
+{
+    for (const Point &seed : seeds)
+    {
+        edges.at<uchar>(seed) = StrongEdge;
+    }
+
+    while (!seeds.empty())
+    {
+        Point p = seeds.back();
+        seeds.pop_back();
+
+        for (int y = max(p.y - 1, band.start); y < min(p.y + 2, band.end); y++)
+        {
+            uchar *row = edges.ptr<uchar>(y);
+            for (int x = max(p.x - 1, 0); x < min(p.x + 2, edges.cols); x++)
+            {
+                if (row[x] == WeakEdge)
+                {
+                    row[x] = StrongEdge;
+                    seeds.emplace_back(x, y);
+                }
+            }
+        }
+    }
+}
+
+// Weak edges on the first and last rows of the band that touch a strong edge of the neighbouring
+// band. Only reads, so every band can look at its neighbours while the others do the same.
+static void collectCrossings(const Mat &edges, const Range &band, vector<Point> &seeds)
+{
+    auto collect = [&](int y, int neighbourY)
+    {
+        if (neighbourY < 0 || neighbourY >= edges.rows)
+            return;
+
+        const uchar *row = edges.ptr<uchar>(y);
+        const uchar *neighbour = edges.ptr<uchar>(neighbourY);
+        for (int x = 0; x < edges.cols; x++)
+        {
+            if (row[x] == WeakEdge &&
+                (neighbour[x] == StrongEdge || (x > 0 && neighbour[x - 1] == StrongEdge) ||
+                 (x + 1 < edges.cols && neighbour[x + 1] == StrongEdge)))
+                seeds.emplace_back(x, y);
+        }
+    };
+
+    collect(band.start, band.start - 1);
+    if (band.end - 1 != band.start)
+        collect(band.end - 1, band.end);
+}
+
+Mat cannyEdges(const Mat &gray, double lowThreshold, double highThreshold)
+{
+    CV_Assert(gray.type() == CV_8UC1);
+
+    if (lowThreshold > highThreshold)
+        swap(lowThreshold, highThreshold);
+    int lowSquared = saturate_cast<int>(pow(max(lowThreshold, 0.0) * gradientScale, 2));
+    int highSquared = saturate_cast<int>(pow(max(highThreshold, 0.0) * gradientScale, 2));
+
+    Mat dx, dy;
+    sobelDerivatives(gray, dx, dy);
+
+    // squared so the comparisons stay in integers, below 2 * (48 * 255)^2
+    Mat magnitude = Mat::zeros(gray.rows + 2, gray.cols + 2, CV_32SC1);
+    parallel_for_(Range(0, gray.rows), [&](const Range &rows)
+                  {
+        for (int y = rows.start; y < rows.end; y++)
+        {
+            const int16_t *dxRow = dx.ptr<int16_t>(y);
+            const int16_t *dyRow = dy.ptr<int16_t>(y);
+            int *magnitudeRow = magnitude.ptr<int>(y + 1) + 1;
+            for (int x = 0; x < gray.cols; x++)
+            {
+                magnitudeRow[x] = dxRow[x] * dxRow[x] + dyRow[x] * dyRow[x];
+            }
+        } });
+
+    Mat edges(gray.size(), CV_8UC1);
+    vector<Range> bands = rowBands(gray.rows);
+    vector<vector<Point>> seeds(bands.size());
+    Range bandIndexes(0, (int)bands.size());
+
+    parallel_for_(bandIndexes, [&](const Range &range)
+                  {
+        for (int i = range.start; i < range.end; i++)
+        {
+            suppressNonMaxima(dx, dy, magnitude, edges, lowSquared, highSquared, bands[i]);
+            for (int y = bands[i].start; y < bands[i].end; y++)
+            {
+                const uchar *row = edges.ptr<uchar>(y);
+                for (int x = 0; x < edges.cols; x++)
+                {
+                    if (row[x] == StrongEdge)
+                        seeds[i].emplace_back(x, y);
+                }
+            }
+        } });
+
+    // Hysteresis as a wavefront: every band grows its own edges, then the weak edges reached from
+    // a neighbouring band seed the next round. An edge crossing k band boundaries takes k rounds.
+    bool hasSeeds = true;
+    while (hasSeeds)
+    {
+        parallel_for_(bandIndexes, [&](const Range &range)
+                      {
+            for (int i = range.start; i < range.end; i++)
+            {
+                growStrongEdges(edges, bands[i], seeds[i]);
+            } });
+        parallel_for_(bandIndexes, [&](const Range &range)
+                      {
+            for (int i = range.start; i < range.end; i++)
+            {
+                collectCrossings(edges, bands[i], seeds[i]);
+            } });
+        hasSeeds = any_of(seeds.begin(), seeds.end(), [](const vector<Point> &bandSeeds)
+                          { return !bandSeeds.empty(); });
+    }
+
+    edges.setTo(NotEdge, edges == WeakEdge);
+    return edges;
+}
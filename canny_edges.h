@@ -0,0 +1,16 @@
+#ifndef CANNY_EDGES_H
+#define CANNY_EDGES_H
+
+#include <opencv2/opencv.hpp>
+
+// Canny edge map of an 8 bit gray plane, 255 on the edges and 0 elsewhere.
+//
+// The gradient comes from the fused 5x5 Sobel pass, non-maximum suppression runs on row bands in
+// parallel and hysteresis grows the strong edges of every band in parallel, repeating across the
+// band boundaries until no weak edge touching a strong one is left.
+//
+// lowThreshold, highThreshold: on the L2 gradient magnitude in the scale of the 3x3 Sobel kernels,
+//                              the scale cv::Canny uses by default
+cv::Mat cannyEdges(const cv::Mat &gray, double lowThreshold, double highThreshold);
+
+#endif // CANNY_EDGES_H
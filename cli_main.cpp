@@ -0,0 +1,272 @@
+#include "batch_processor.h"
+#include "fixed_kernels.h"
+#include "image_operation.h"
+#include "image_processing.h"
+#include "recipe.h"
+#include "smoothing_filter.h"
+#include "tiled_processor.h"
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+void printUsage(const string &program)
+{
+    cerr << "Usage: " << program << " <input> <output> <operation>..." << endl
+         << "       " << program << " batch <input directory|list file> <output directory> [--threads N] [--format .ext] <operation>..." << endl
+         << "       " << program << " stream <input> <output> [--tile-rows N] <operation>..." << endl
+         << "       " << program << " bench <input> [--iterations N]" << endl
+         << endl
+         << "Applies the operations in order without opening any window, e.g." << endl
+         << "  " << program << " scan.png edges.png grayscale \"median(3)\" \"sobel(both)\" \"threshold(t0=80)\"" << endl
+         << "\"--recipe file\" can be used in place of operations, \"--explain\" prints the execution plan." << endl
+         << endl
+         << "Operations:" << endl
+         << "  grayscale, negative, log, bitslice, equalize, laplacian" << endl
+         << "  flip(horizontal|vertical|both)" << endl
+         << "  gamma(value)" << endl
+         << "  median(size[, colour])" << endl
+         << "  sobel(horizontal|vertical|both|direction)" << endl
+         << "  threshold(t0=value|auto)" << endl
+         << "  canny(low=value, high=value)" << endl
+         << "  laplacian(contrast=value, sigma=value[, value...])" << endl
+         << "  lowpass(d0=value[, gaussian|butterworth[, order=n]]), highpass(...)" << endl
+         << "  bandpass(d0=value, width=value[, gaussian|butterworth[, order=n]]), bandstop(...)" << endl
+         << "  smooth(level 1-4[, x:y:width:height...])" << endl
+         << "  slice(from:to...[, keep])" << endl
+         << "  zoom(x:y:width:height...)" << endl
+         << "  crop(x:y:width:height)" << endl
+         << "  affine(m00, m01, m02, m10, m11, m12)" << endl;
+}
+
+bool parseOperations(int argc, char *argv[], int first, vector<ImageOperation> &operations)
+{
+    for (int i = first; i < argc; i++)
+    {
+        string argument = argv[i];
+        string error;
+
+        if (argument == "--explain")
+            continue;
+
+        if (argument == "--recipe" && i + 1 < argc)
+        {
+            if (!loadRecipe(argv[++i], operations, error))
+            {
+                cerr << "Error: " << error << endl;
+                return false;
+            }
+            continue;
+        }
+
+        ImageOperation operation;
+        if (!parseOperation(argument, operation, error))
+        {
+            cerr << "Error: " << error << endl;
+            return false;
+        }
+        operations.push_back(operation);
+    }
+
+    if (operations.empty())
+    {
+        cerr << "Error: no operation given" << endl;
+        return false;
+    }
+
+    for (int i = first; i < argc; i++)
+    {
+        if (string(argv[i]) == "--explain")
+            cerr << describePlan(planRecipe(operations)) << endl;
+    }
+
+    return true;
+}
+
+int runSingleImage(int argc, char *argv[])
+{
+    vector<ImageOperation> operations;
+    if (!parseOperations(argc, argv, 3, operations))
+        return 1;
+
+    Mat image = imread(argv[1]);
+    if (image.empty())
+    {
+        cerr << "Error: failed to load the image " << argv[1] << endl;
+        return 1;
+    }
+
+    try
+    {
+        image = executePlan(image, planRecipe(operations));
+    }
+    catch (const cv::Exception &exception)
+    {
+        cerr << "Error: " << exception.what() << endl;
+        return 1;
+    }
+
+    if (!imwrite(argv[2], image))
+    {
+        cerr << "Error: failed to save the image " << argv[2] << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int runBatchCommand(int argc, char *argv[])
+{
+    string source = argv[2];
+    string outputDirectory = argv[3];
+    BatchOptions options;
+
+    int first = 4;
+    while (first + 1 < argc && string(argv[first]).rfind("--", 0) == 0)
+    {
+        string option = argv[first];
+        if (option == "--threads")
+            options.threadCount = atoi(argv[first + 1]);
+        else if (option == "--format")
+            options.outputExtension = argv[first + 1];
+        else if (option == "--recipe" || option == "--explain")
+            break;
+        else
+        {
+            cerr << "Error: unknown option " << option << endl;
+            return 1;
+        }
+        first += 2;
+    }
+
+    vector<ImageOperation> operations;
+    if (!parseOperations(argc, argv, first, operations))
+        return 1;
+
+    vector<string> inputPaths;
+    string error;
+    if (!collectBatchInputs(source, inputPaths, error))
+    {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+
+    BatchSummary summary = runBatch(inputPaths, outputDirectory, operations, options, [](const BatchFileResult &result)
+                                    {
+        if (result.succeeded)
+            printf("%s: decode %.1f ms, process %.1f ms, encode %.1f ms\n", result.inputPath.c_str(), result.decodeMs, result.processMs, result.encodeMs);
+        else
+            printf("%s: FAILED, %s\n", result.inputPath.c_str(), result.error.c_str()); });
+
+    if (!summary.error.empty())
+    {
+        cerr << "Error: " << summary.error << endl;
+        return 1;
+    }
+
+    double seconds = summary.seconds > 0 ? summary.seconds : 1e-9;
+    printf("\n%d files, %d failed, %.2f s, %.1f images/s, %.1f MP/s\n", summary.files, summary.failed, summary.seconds,
+           (summary.files - summary.failed) / seconds, summary.pixels / 1e6 / seconds);
+
+    return summary.failed == 0 ? 0 : 1;
+}
+
+// Images larger than the memory are streamed through the neighbourhood and point operations,
+// binary PGM/PPM input and output are never held whole
+int runStreamCommand(int argc, char *argv[])
+{
+    TiledOptions options;
+
+    int first = 4;
+    if (first + 1 < argc && string(argv[first]) == "--tile-rows")
+    {
+        options.tileRows = atoi(argv[first + 1]);
+        first += 2;
+    }
+
+    vector<ImageOperation> operations;
+    if (!parseOperations(argc, argv, first, operations))
+        return 1;
+
+    string error;
+    if (!runTiled(argv[2], argv[3], operations, options, error))
+    {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// Times the smoothing levels through the float filter2D path and the fixed point engine
+int runBenchCommand(int argc, char *argv[])
+{
+    int iterations = 20;
+    if (argc >= 5 && string(argv[3]) == "--iterations")
+        iterations = max(1, atoi(argv[4]));
+
+    Mat image = imread(argv[2]);
+    if (image.empty())
+    {
+        cerr << "Error: failed to load the image " << argv[2] << endl;
+        return 1;
+    }
+
+    printf("%dx%d, %d channels, %d iterations\n", image.cols, image.rows, image.channels(), iterations);
+
+    for (int level = (int)SmoothingLevel::Traditional3x3; level <= (int)SmoothingLevel::Cone5x5; level++)
+    {
+        Mat kernel = smoothingKernel((SmoothingLevel)level);
+        Mat floatResult, fixedResult;
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            filter2D(image, floatResult, -1, kernel);
+        }
+        double floatMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / iterations;
+
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            smoothingFilter(image, fixedResult, kernel);
+        }
+        double fixedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / iterations;
+
+        IntegerKernel integerKernel;
+        const char *path = !integerKernelOf(kernel, integerKernel) ? "generic"
+                           : !integerKernel.row.empty()            ? "separable"
+                           : isFixedKernel(kernel)                 ? "unrolled"
+                                                                   : "2-D";
+        printf("smooth(%d) %s: filter2D %.2f ms, fixed point %.2f ms, %.2fx, max difference %.0f\n", level, path,
+               floatMs, fixedMs, floatMs / max(fixedMs, 1e-6), norm(floatResult, fixedResult, NORM_INF));
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 3 && string(argv[1]) == "bench")
+        return runBenchCommand(argc, argv);
+
+    if (argc >= 5 && string(argv[1]) == "batch")
+        return runBatchCommand(argc, argv);
+
+    if (argc >= 5 && string(argv[1]) == "stream")
+        return runStreamCommand(argc, argv);
+
+    if (argc < 4)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    return runSingleImage(argc, argv);
+}
@@ -1,5 +1,7 @@
 #include "clickable_label.h"
+#include <QApplication>
 #include <QMouseEvent>
+#include <QWheelEvent>
 
 ClickableLabel::ClickableLabel(QWidget* parent, Qt::WindowFlags f)
     : QLabel(parent, f)
@@ -9,7 +11,38 @@ ClickableLabel::ClickableLabel(QWidget* parent, Qt::WindowFlags f)
 void ClickableLabel::mousePressEvent(QMouseEvent* event)
 {
     if (event->button() == Qt::LeftButton) {
-        emit clicked();
+        lastPosition = event->position().toPoint();
+        isDragging = false;
     }
     QLabel::mousePressEvent(event);
-}
\ No newline at end of file
+}
+
+void ClickableLabel::mouseMoveEvent(QMouseEvent* event)
+{
+    if (event->buttons() & Qt::LeftButton) {
+        QPoint offset = event->position().toPoint() - lastPosition;
+        // small movements while clicking are not a drag
+        if (isDragging || offset.manhattanLength() >= QApplication::startDragDistance()) {
+            isDragging = true;
+            lastPosition = event->position().toPoint();
+            emit dragged(offset);
+        }
+    }
+    QLabel::mouseMoveEvent(event);
+}
+
+void ClickableLabel::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton && !isDragging) {
+        emit clicked();
+    }
+    isDragging = false;
+    QLabel::mouseReleaseEvent(event);
+}
+
+void ClickableLabel::wheelEvent(QWheelEvent* event)
+{
+    // angleDelta is in eighths of a degree, a notch is 15 degrees
+    emit wheelScrolled(event->position().toPoint(), event->angleDelta().y() / 120.0);
+    event->accept();
+}
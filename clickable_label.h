@@ -2,6 +2,7 @@
 #define CLICKABLE_LABEL_H
 
 #include <QLabel>
+#include <QPoint>
 #include <QWidget>
 #include <Qt>
 
@@ -14,10 +15,22 @@ public:
     ~ClickableLabel() = default;
 
 signals:
+    // left button released without dragging
     void clicked();
+    // the mouse moved by offset with the left button down
+    void dragged(QPoint offset);
+    // wheel turned by steps notches (positive away from the user) with the cursor at position
+    void wheelScrolled(QPoint position, double steps);
 
 protected:
     void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+
+private:
+    QPoint lastPosition;
+    bool isDragging = false;
 };
 
-#endif // CLICKABLE_LABEL_H
\ No newline at end of file
+#endif // CLICKABLE_LABEL_H
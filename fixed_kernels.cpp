@@ -0,0 +1,141 @@
+#include "fixed_kernels.h"
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+using namespace cv;
+using namespace std;
+
+// Sum of the positive (or negative) weights, the range of a sum of 8 bit pixels is 255 times these
+template <const auto &Kernel>
+constexpr int weightSum(bool isPositive)
+{
+    int sum = 0;
+    for (int i = 0; i < Kernel.rows; i++)
+    {
+        for (int j = 0; j < Kernel.cols; j++)
+        {
+            if ((Kernel.weights[i][j] > 0) == isPositive)
+                sum += Kernel.weights[i][j];
+        }
+    }
+    return sum;
+}
+
+// Narrowest type holding every weighted sum of 8 bit pixels
+template <const auto &Kernel>
+using AccumulatorOf = conditional_t<weightSum<Kernel>(false) == 0 && weightSum<Kernel>(true) * 255 <= UINT16_MAX, uint16_t,
+                                    conditional_t<weightSum<Kernel>(false) * 255 >= INT16_MIN && weightSum<Kernel>(true) * 255 <= INT16_MAX, int16_t, int32_t>>;
+
+// Weighted pixel of one tap, a zero weight is no code at all and a weight of 1 no multiplication
+template <const auto &Kernel, int Tap, typename Accumulator>
+inline Accumulator tapOf(const uchar *const *rows, int x, int channels)
+{
+    constexpr int i = Tap / Kernel.cols;
+    constexpr int j = Tap % Kernel.cols;
+    constexpr int weight = Kernel.weights[i][j];
+
+    if constexpr (weight == 0)
+        return 0;
+    else if constexpr (weight == 1)
+        return rows[i][x + j * channels];
+    else
+        return (Accumulator)(weight * rows[i][x + j * channels]);
+}
+
+// The divisor is a constant, the compiler turns the division into a multiplication
+template <const auto &Kernel, typename Accumulator>
+inline uchar outputOf(Accumulator sum)
+{
+    constexpr int divisor = Kernel.divisor;
+
+    if constexpr (divisor == 1)
+        return saturate_cast<uchar>((int)sum);
+    else if constexpr (is_unsigned_v<Accumulator>)
+        return (uchar)min(((int)sum + divisor / 2) / divisor, 255);
+    else
+        return saturate_cast<uchar>(cvRound((float)sum / divisor));
+}
+
+template <const auto &Kernel, int... Taps>
+static void convolveRow(const uchar *const *rows, uchar *dst, int length, int channels, integer_sequence<int, Taps...>)
+{
+    using Accumulator = AccumulatorOf<Kernel>;
+    for (int x = 0; x < length; x++)
+    {
+        Accumulator sum = 0;
+        ((sum += tapOf<Kernel, Taps, Accumulator>(rows, x, channels)), ...);
+        dst[x] = outputOf<Kernel>(sum);
+    }
+}
+
+template <const auto &Kernel>
+static void convolve(const Mat &src, Mat &dst)
+{
+    constexpr int radiusY = Kernel.rows / 2;
+    constexpr int radiusX = Kernel.cols / 2;
+    int channels = src.channels();
+    int length = src.cols * channels;
+
+    // a submatrix takes its border from the parent image, like filter2D
+    Mat padded;
+    copyMakeBorder(src, padded, radiusY, radiusY, radiusX, radiusX, BORDER_REFLECT_101);
+    dst.create(src.size(), CV_MAKETYPE(CV_8U, channels));
+
+    parallel_for_(Range(0, src.rows), [&](const Range &range)
+                  {
+        const uchar *rows[Kernel.rows];
+        for (int y = range.start; y < range.end; y++)
+        {
+            for (int i = 0; i < Kernel.rows; i++)
+            {
+                rows[i] = padded.ptr<uchar>(y + i);
+            }
+            convolveRow<Kernel>(rows, dst.ptr<uchar>(y), length, channels, make_integer_sequence<int, Kernel.rows * Kernel.cols>());
+        } });
+}
+
+template <const auto &Kernel>
+static bool matches(const Mat &kernel)
+{
+    if (kernel.rows != Kernel.rows || kernel.cols != Kernel.cols || kernel.channels() != 1)
+        return false;
+
+    Mat weights;
+    kernel.convertTo(weights, CV_64F);
+    for (int i = 0; i < Kernel.rows; i++)
+    {
+        for (int j = 0; j < Kernel.cols; j++)
+        {
+            if (fabs(weights.at<double>(i, j) - (double)Kernel.weights[i][j] / Kernel.divisor) > 1e-6)
+                return false;
+        }
+    }
+    return true;
+}
+
+template <const auto &...Kernels>
+static bool filterWithFixedKernel(FixedKernelList<Kernels...>, const Mat &src, Mat &dst, const Mat &kernel)
+{
+    return ((matches<Kernels>(kernel) && (convolve<Kernels>(src, dst), true)) || ...);
+}
+
+template <const auto &...Kernels>
+static bool isAnyOf(FixedKernelList<Kernels...>, const Mat &kernel)
+{
+    return (matches<Kernels>(kernel) || ...);
+}
+
+bool isFixedKernel(const Mat &kernel)
+{
+    return isAnyOf(FixedKernels(), kernel);
+}
+
+bool fixedKernelFilter(const Mat &src, Mat &dst, const Mat &kernel)
+{
+    if (src.empty() || src.depth() != CV_8U)
+        return false;
+
+    return filterWithFixedKernel(FixedKernels(), src, dst, kernel);
+}
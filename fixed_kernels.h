@@ -0,0 +1,54 @@
+#ifndef FIXED_KERNELS_H
+#define FIXED_KERNELS_H
+
+#include <opencv2/opencv.hpp>
+
+// The convolution kernels built into the application as integer weights over a divisor, known at
+// compile time. Each one listed in FixedKernels gets its own convolution with the taps unrolled,
+// the zero weights left out and the narrowest accumulator that can't overflow.
+template <int Rows, int Cols>
+struct FixedKernel
+{
+    static constexpr int rows = Rows;
+    static constexpr int cols = Cols;
+    int weights[Rows][Cols];
+    int divisor;
+};
+
+inline constexpr FixedKernel<3, 3> traditionalWeights3x3{{{1, 1, 1}, {1, 1, 1}, {1, 1, 1}}, 9};
+inline constexpr FixedKernel<5, 5> pyramidalWeights5x5{{{1, 2, 3, 2, 1}, {2, 4, 6, 4, 2}, {3, 6, 9, 6, 3}, {2, 4, 6, 4, 2}, {1, 2, 3, 2, 1}}, 81};
+inline constexpr FixedKernel<5, 5> circularWeights5x5{{{0, 1, 1, 1, 0}, {1, 1, 1, 1, 1}, {1, 1, 1, 1, 1}, {1, 1, 1, 1, 1}, {0, 1, 1, 1, 0}}, 21};
+inline constexpr FixedKernel<5, 5> coneWeights5x5{{{0, 0, 1, 0, 0}, {0, 2, 2, 2, 0}, {1, 2, 5, 2, 1}, {0, 2, 2, 2, 0}, {0, 0, 1, 0, 0}}, 25};
+inline constexpr FixedKernel<5, 5> laplacianOfGaussianWeights5x5{{{0, 0, -1, 0, 0}, {0, -1, -2, -1, 0}, {-1, -2, 16, -2, -1}, {0, -1, -2, -1, 0}, {0, 0, -1, 0, 0}}, 1};
+
+template <const auto &...Kernels>
+struct FixedKernelList
+{
+};
+
+// A new fixed kernel is its table above and an entry here
+using FixedKernels = FixedKernelList<traditionalWeights3x3, pyramidalWeights5x5, circularWeights5x5, coneWeights5x5, laplacianOfGaussianWeights5x5>;
+
+// CV_32FC1 kernel of weights / divisor, as filter2D takes it
+template <int Rows, int Cols>
+cv::Mat kernelOf(const FixedKernel<Rows, Cols> &kernel)
+{
+    cv::Mat mat(Rows, Cols, CV_32FC1);
+    for (int i = 0; i < Rows; i++)
+    {
+        for (int j = 0; j < Cols; j++)
+        {
+            mat.at<float>(i, j) = (float)kernel.weights[i][j] / kernel.divisor;
+        }
+    }
+    return mat;
+}
+
+// filter2D(src, dst, CV_8U, kernel) with the default BORDER_REFLECT_101 through the specialised
+// convolution of the fixed kernel equal to kernel, false when src isn't 8 bit or kernel is none of
+// FixedKernels. Smoothing kernels are rounded from the exact integer sum.
+bool fixedKernelFilter(const cv::Mat &src, cv::Mat &dst, const cv::Mat &kernel);
+// Whether kernel is one of FixedKernels
+bool isFixedKernel(const cv::Mat &kernel);
+
+#endif // FIXED_KERNELS_H
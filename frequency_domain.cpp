@@ -0,0 +1,207 @@
+#include "frequency_domain.h"
+#include "image_processing.h"
+#include <cmath>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+bool operator==(const FrequencyFilter &first, const FrequencyFilter &second)
+{
+    return first.band == second.band && first.shape == second.shape && first.d0 == second.d0 &&
+           first.width == second.width && first.order == second.order;
+}
+
+// Columns of a CCS spectrum hold the Re/Im pairs of the horizontal frequencies 0..n/2. The first
+// column, and the last one for even widths, are the spectra of real columns and are packed the
+// same way down the rows, every other column has the vertical frequencies of a full spectrum.
+static bool isPackedColumn(int column, int width)
+{
+    return column == 0 || (width % 2 == 0 && column == width - 1);
+}
+
+// Frequency steps are scaled by scaleU, scaleV to those of the reference image
+static Mat ccsDistances(Size size, double scaleU, double scaleV)
+{
+    int m = size.height;
+    int n = size.width;
+    Mat distance(size, CV_32FC1);
+
+    for (int r = 0; r < m; r++)
+    {
+        float *row = distance.ptr<float>(r);
+        for (int c = 0; c < n; c++)
+        {
+            double v = (c + 1) / 2 * scaleV;
+            double u = (isPackedColumn(c, n) ? (r + 1) / 2 : min(r, m - r)) * scaleU;
+            row[c] = (float)sqrt(u * u + v * v);
+        }
+    }
+    return distance;
+}
+
+// Magnitude of the full spectrum, both halves filled from the conjugate symmetry
+static Mat ccsMagnitude(const Mat &ccs)
+{
+    int m = ccs.rows;
+    int n = ccs.cols;
+    Mat magnitude = Mat::zeros(ccs.size(), CV_32FC1);
+    auto set = [&](int u, int v, float value)
+    {
+        magnitude.at<float>(u, v) = value;
+        magnitude.at<float>((m - u) % m, (n - v) % n) = value;
+    };
+
+    vector<int> packedColumns = {0};
+    if (n > 1 && isPackedColumn(n - 1, n))
+        packedColumns.push_back(n - 1);
+
+    for (int c : packedColumns)
+    {
+        int v = c == 0 ? 0 : n / 2;
+        set(0, v, fabs(ccs.at<float>(0, c)));
+        for (int u = 1; 2 * u - 1 < m; u++)
+        {
+            float imaginary = 2 * u < m ? ccs.at<float>(2 * u, c) : 0;
+            set(u, v, hypot(ccs.at<float>(2 * u - 1, c), imaginary));
+        }
+    }
+
+    int pairsEnd = n % 2 == 0 ? n - 1 : n;
+    for (int c = 1; c + 1 < pairsEnd; c += 2)
+    {
+        for (int r = 0; r < m; r++)
+        {
+            set(r, (c + 1) / 2, hypot(ccs.at<float>(r, c), ccs.at<float>(r, c + 1)));
+        }
+    }
+
+    return magnitude;
+}
+
+static double lowPassResponse(const FrequencyFilter &filter, double distance)
+{
+    switch (filter.shape)
+    {
+    case FrequencyFilterShape::Gaussian:
+        return exp(-distance * distance / (2 * filter.d0 * filter.d0));
+    case FrequencyFilterShape::Butterworth:
+        return 1 / (1 + pow(distance / filter.d0, 2 * filter.order));
+    case FrequencyFilterShape::Ideal:
+    default:
+        return distance < filter.d0 ? 1 : 0;
+    }
+}
+
+static double bandStopResponse(const FrequencyFilter &filter, double distance)
+{
+    double offset = distance * distance - filter.d0 * filter.d0;
+    switch (filter.shape)
+    {
+    case FrequencyFilterShape::Gaussian:
+        return distance == 0 ? 1 : 1 - exp(-pow(offset / (distance * filter.width), 2));
+    case FrequencyFilterShape::Butterworth:
+        return offset == 0 ? 0 : 1 / (1 + pow(distance * filter.width / offset, 2 * filter.order));
+    case FrequencyFilterShape::Ideal:
+    default:
+        return fabs(distance - filter.d0) <= filter.width / 2 ? 0 : 1;
+    }
+}
+
+static double filterResponse(const FrequencyFilter &filter, double distance)
+{
+    switch (filter.band)
+    {
+    case FrequencyBand::HighPass:
+        return 1 - lowPassResponse(filter, distance);
+    case FrequencyBand::BandPass:
+        return 1 - bandStopResponse(filter, distance);
+    case FrequencyBand::BandStop:
+        return bandStopResponse(filter, distance);
+    case FrequencyBand::LowPass:
+    default:
+        return lowPassResponse(filter, distance);
+    }
+}
+
+FrequencyDomainSession::FrequencyDomainSession(const Mat &gray, Size referenceSize)
+    : imageSize(gray.size())
+{
+    if (referenceSize.empty())
+        referenceSize = imageSize;
+
+    Size paddedSize(getOptimalDFTSize(gray.cols), getOptimalDFTSize(gray.rows));
+    int maxPixelValue = pow(2, imageDepth2Bits(gray.depth())) - 1;
+
+    Mat padded = Mat::zeros(paddedSize, CV_32FC1);
+    Mat imageArea = padded(Rect(Point(), imageSize));
+    gray.convertTo(imageArea, CV_32FC1, 1.0 / maxPixelValue);
+
+    // the rows below the image are zero, the transform skips them
+    dft(padded, spectrum, 0, imageSize.height);
+
+    // a step of u cycles per padded height is u * rows / paddedRows cycles per image, the same
+    // number of cycles is a different step in the padded transform of the reference image
+    double scaleU = (double)imageSize.height / paddedSize.height * getOptimalDFTSize(referenceSize.height) / referenceSize.height;
+    double scaleV = (double)imageSize.width / paddedSize.width * getOptimalDFTSize(referenceSize.width) / referenceSize.width;
+    distance = ccsDistances(paddedSize, scaleU, scaleV);
+}
+
+bool FrequencyDomainSession::empty() const
+{
+    return spectrum.empty();
+}
+
+Mat FrequencyDomainSession::filter(const FrequencyFilter &filter)
+{
+    // the response only depends on the distance to the zero frequency, the same for both elements
+    // of a Re/Im pair and for a frequency and its conjugate, so it applies to the packed spectrum
+    response.create(distance.size(), CV_32FC1);
+    parallel_for_(Range(0, distance.rows), [&](const Range &rows)
+                  {
+        for (int r = rows.start; r < rows.end; r++)
+        {
+            const float *distanceRow = distance.ptr<float>(r);
+            float *responseRow = response.ptr<float>(r);
+            for (int c = 0; c < distance.cols; c++)
+            {
+                responseRow[c] = (float)filterResponse(filter, distanceRow[c]);
+            }
+        } });
+    multiply(spectrum, response, filtered);
+
+    // the response is symmetric so the inverse is real, only the rows of the image are computed
+    dft(filtered, inverse, DFT_INVERSE | DFT_REAL_OUTPUT, imageSize.height);
+
+    Mat dstImage = abs(inverse(Rect(Point(), imageSize)));
+    normalize(dstImage, dstImage, 0, 1, NORM_MINMAX);
+    return dstImage;
+}
+
+Mat FrequencyDomainSession::spectrumImage() const
+{
+    Mat magnitude = ccsMagnitude(filtered.empty() ? spectrum : filtered);
+    magnitude += Scalar::all(1);
+    log(magnitude, magnitude);
+
+    // zero frequency in the centre
+    int m = magnitude.rows;
+    int n = magnitude.cols;
+    Mat centred(magnitude.size(), CV_32FC1);
+    for (int r = 0; r < m; r++)
+    {
+        for (int c = 0; c < n; c++)
+        {
+            centred.at<float>((r + m / 2) % m, (c + n / 2) % n) = magnitude.at<float>(r, c);
+        }
+    }
+
+    Mat view;
+    normalize(centred, view, 0, 255, NORM_MINMAX, CV_8U);
+    return view;
+}
+
+Mat frequencyDomainFilter(const Mat &gray, const FrequencyFilter &filter)
+{
+    return FrequencyDomainSession(gray).filter(filter);
+}
@@ -0,0 +1,71 @@
+#ifndef FREQUENCY_DOMAIN_H
+#define FREQUENCY_DOMAIN_H
+
+#include <opencv2/opencv.hpp>
+
+enum class FrequencyFilterShape
+{
+    Ideal,
+    Gaussian,
+    Butterworth
+};
+
+// Stored as the option of a frequency domain operation, 1 and 0 were the low and high pass filters
+// before band filters existed
+enum class FrequencyBand
+{
+    HighPass = 0,
+    LowPass = 1,
+    BandPass = 2,
+    BandStop = 3
+};
+
+struct FrequencyFilter
+{
+    FrequencyBand band = FrequencyBand::LowPass;
+    FrequencyFilterShape shape = FrequencyFilterShape::Ideal;
+    // cutoff, or centre of the band, in frequency steps of the full resolution image
+    double d0 = 50;
+    // band pass/stop only
+    double width = 20;
+    // Butterworth only
+    int order = 2;
+};
+
+bool operator==(const FrequencyFilter &first, const FrequencyFilter &second);
+
+// Frequency domain filtering of one gray plane with the forward transform done once. The spectrum
+// is the real to complex DFT in CCS packed form (half the work and memory of the complex one) and
+// the distance of every packed element from the zero frequency is precomputed, so a new filter
+// only multiplies the spectrum by its response and runs the inverse transform.
+class FrequencyDomainSession
+{
+public:
+    FrequencyDomainSession() = default;
+    // referenceSize is the size of the image the cutoffs refer to when gray is a downscaled
+    // preview of it, the distances are scaled so d0 keeps its meaning
+    explicit FrequencyDomainSession(const cv::Mat &gray, cv::Size referenceSize = cv::Size());
+
+    bool empty() const;
+    // CV_32FC1 of the size of the gray plane normalized to [0, 1]
+    cv::Mat filter(const FrequencyFilter &filter);
+    // Centred log magnitude of the last filtered spectrum (of the unfiltered one before the first
+    // filter), 8 bit
+    cv::Mat spectrumImage() const;
+
+private:
+    cv::Size imageSize;
+    // CCS packed forward transform of the zero padded plane, CV_32FC1
+    cv::Mat spectrum;
+    // distance of the frequency of every element of spectrum from the zero frequency
+    cv::Mat distance;
+    // reused between filters
+    cv::Mat response;
+    cv::Mat filtered;
+    cv::Mat inverse;
+};
+
+// One-shot filter of the full resolution plane
+cv::Mat frequencyDomainFilter(const cv::Mat &gray, const FrequencyFilter &filter);
+
+#endif // FREQUENCY_DOMAIN_H
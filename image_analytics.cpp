@@ -0,0 +1,230 @@
+#include "image_analytics.h"
+#include "point_lut.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+Mat grayPlaneOf(const Mat &image)
+{
+    if (image.channels() == 1)
+        return image;
+
+    // same conversion as the rest of the tools
+    Mat gray;
+    cvtColor(image, gray, COLOR_RGB2GRAY);
+    return gray;
+}
+
+static double entropyOf(const vector<long long> &histogram)
+{
+    long long total = 0;
+    for (long long count : histogram)
+        total += count;
+
+    double entropy = 0;
+    for (long long count : histogram)
+    {
+        if (count > 0)
+        {
+            double probability = (double)count / total;
+            entropy -= probability * log2(probability);
+        }
+    }
+    return entropy;
+}
+
+ImageAnalytics computeImageAnalytics(const Mat &image, Mat gray)
+{
+    ImageAnalytics analytics;
+
+    if (image.depth() == CV_8U)
+    {
+        if (gray.empty() && image.channels() != 1)
+            gray = grayPlaneOf(image);
+        // Everything else follows from the histograms: exact 64 bit counts, and the only pass
+        // over the pixels is the parallel histogram (plus the gray plane for colour images)
+        analytics.channelHistograms = channelHistograms(image);
+        analytics.grayHistogram = image.channels() == 1 ? analytics.channelHistograms[0] : grayHistogram(gray);
+        analytics.entropy = entropyOf(analytics.grayHistogram);
+
+        for (const vector<long long> &histogram : analytics.channelHistograms)
+        {
+            int minimum = 255;
+            int maximum = 0;
+            long long total = 0;
+            long long sum = 0;
+            long long squaredSum = 0;
+            for (int value = 0; value < 256; value++)
+            {
+                if (histogram[value] == 0)
+                    continue;
+                minimum = min(minimum, value);
+                maximum = max(maximum, value);
+                total += histogram[value];
+                sum += histogram[value] * value;
+                squaredSum += histogram[value] * value * value;
+            }
+
+            double mean = total > 0 ? (double)sum / total : 0;
+            analytics.minimum.push_back(total > 0 ? minimum : 0);
+            analytics.maximum.push_back(total > 0 ? maximum : 0);
+            analytics.mean.push_back(mean);
+            analytics.stddev.push_back(total > 0 ? sqrt(max(0.0, (double)squaredSum / total - mean * mean)) : 0);
+        }
+        return analytics;
+    }
+
+    vector<Mat> planes;
+    split(image, planes);
+    for (const Mat &plane : planes)
+    {
+        double minimum = 0, maximum = 0;
+        minMaxLoc(plane, &minimum, &maximum);
+        Scalar mean, stddev;
+        meanStdDev(plane, mean, stddev);
+
+        analytics.minimum.push_back(minimum);
+        analytics.maximum.push_back(maximum);
+        analytics.mean.push_back(mean[0]);
+        analytics.stddev.push_back(stddev[0]);
+    }
+    return analytics;
+}
+
+Mat histogramImage(const vector<vector<long long>> &histograms, int height)
+{
+    // one curve per channel, in the colour of the channel for BGR images
+    static const Scalar colours[] = {Scalar(255, 0, 0), Scalar(0, 160, 0), Scalar(0, 0, 255), Scalar(128, 128, 128)};
+
+    Mat plot(height, 512, CV_8UC3, Scalar(255, 255, 255));
+    long long highest = 1;
+    for (const vector<long long> &histogram : histograms)
+        highest = max(highest, *max_element(histogram.begin(), histogram.end()));
+
+    for (size_t c = 0; c < histograms.size(); c++)
+    {
+        Scalar colour = histograms.size() == 1 ? Scalar(0, 0, 0) : colours[c % 4];
+        vector<Point> points;
+        for (int value = 0; value < 256; value++)
+        {
+            points.push_back(Point(value * 2, height - 1 - (int)(histograms[c][value] * (height - 1) / highest)));
+        }
+        polylines(plot, points, false, colour, 1, LINE_AA);
+    }
+
+    return plot;
+}
+
+IntegralHistogram::IntegralHistogram(const Mat &gray, int blockSize)
+    : gray(gray),
+      lut(identityLut()),
+      blockSize(max(1, blockSize)),
+      gridRows((gray.rows + this->blockSize - 1) / this->blockSize),
+      gridCols((gray.cols + this->blockSize - 1) / this->blockSize),
+      cumulative((size_t)(gridRows + 1) * (gridCols + 1) * 256, 0)
+{
+    CV_Assert(gray.type() == CV_8UC1 && gray.total() < UINT32_MAX);
+
+    // counts of every block, each block row is independent
+    parallel_for_(Range(0, gridRows), [&](const Range &blockRows)
+                  {
+        for (int gridRow = blockRows.start; gridRow < blockRows.end; gridRow++)
+        {
+            int rowEnd = min(gray.rows, (gridRow + 1) * this->blockSize);
+            for (int i = gridRow * this->blockSize; i < rowEnd; i++)
+            {
+                const uchar *row = gray.ptr<uchar>(i);
+                for (int j = 0; j < gray.cols; j++)
+                {
+                    cumulative[cellIndex(gridRow + 1, j / this->blockSize + 1) + row[j]]++;
+                }
+            }
+        } });
+
+    // then summed along the rows and the columns of the grid
+    for (int gridRow = 1; gridRow <= gridRows; gridRow++)
+    {
+        for (int gridCol = 1; gridCol <= gridCols; gridCol++)
+        {
+            uint32_t *cell = &cumulative[cellIndex(gridRow, gridCol)];
+            const uint32_t *left = &cumulative[cellIndex(gridRow, gridCol - 1)];
+            const uint32_t *above = &cumulative[cellIndex(gridRow - 1, gridCol)];
+            const uint32_t *aboveLeft = &cumulative[cellIndex(gridRow - 1, gridCol - 1)];
+            for (int value = 0; value < 256; value++)
+            {
+                cell[value] += left[value] + above[value] - aboveLeft[value];
+            }
+        }
+    }
+}
+
+bool IntegralHistogram::empty() const
+{
+    return gray.empty();
+}
+
+int IntegralHistogram::cellIndex(int gridRow, int gridCol) const
+{
+    return (gridRow * (gridCols + 1) + gridCol) * 256;
+}
+
+vector<long long> IntegralHistogram::histogram(Rect region) const
+{
+    vector<long long> counts(256, 0);
+    region &= Rect(0, 0, gray.cols, gray.rows);
+    if (region.empty())
+        return counts;
+
+    const uchar *table = lut.ptr<uchar>();
+    auto countPixels = [&](Rect rect)
+    {
+        for (int i = rect.y; i < rect.y + rect.height; i++)
+        {
+            const uchar *row = gray.ptr<uchar>(i);
+            for (int j = rect.x; j < rect.x + rect.width; j++)
+            {
+                counts[table[row[j]]]++;
+            }
+        }
+    };
+
+    // whole blocks inside the region, the last block of a row or column may be cut by the image
+    int firstCol = (region.x + blockSize - 1) / blockSize;
+    int lastCol = region.x + region.width == gray.cols ? gridCols : (region.x + region.width) / blockSize;
+    int firstRow = (region.y + blockSize - 1) / blockSize;
+    int lastRow = region.y + region.height == gray.rows ? gridRows : (region.y + region.height) / blockSize;
+
+    if (firstCol >= lastCol || firstRow >= lastRow)
+    {
+        countPixels(region);
+        return counts;
+    }
+
+    const uint32_t *bottomRight = &cumulative[cellIndex(lastRow, lastCol)];
+    const uint32_t *bottomLeft = &cumulative[cellIndex(lastRow, firstCol)];
+    const uint32_t *topRight = &cumulative[cellIndex(firstRow, lastCol)];
+    const uint32_t *topLeft = &cumulative[cellIndex(firstRow, firstCol)];
+    for (int value = 0; value < 256; value++)
+    {
+        counts[table[value]] += (long long)bottomRight[value] - bottomLeft[value] - topRight[value] + topLeft[value];
+    }
+
+    // and the strips around them
+    Rect inner(firstCol * blockSize, firstRow * blockSize, 0, 0);
+    inner.width = min(lastCol * blockSize, gray.cols) - inner.x;
+    inner.height = min(lastRow * blockSize, gray.rows) - inner.y;
+
+    countPixels(Rect(region.x, region.y, region.width, inner.y - region.y));
+    countPixels(Rect(region.x, inner.y + inner.height, region.width, region.y + region.height - inner.y - inner.height));
+    countPixels(Rect(region.x, inner.y, inner.x - region.x, inner.height));
+    countPixels(Rect(inner.x + inner.width, inner.y, region.x + region.width - inner.x - inner.width, inner.height));
+
+    return counts;
+}
+
+void IntegralHistogram::remap(const Mat &lut)
+{
+    this->lut = composeLuts(this->lut, lut);
+}
@@ -0,0 +1,58 @@
+#ifndef IMAGE_ANALYTICS_H
+#define IMAGE_ANALYTICS_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+// Statistics of one revision, computed once and read by every tool instead of rescanning the
+// pixels (gray level tools, automatic threshold, equalization, image properties)
+struct ImageAnalytics
+{
+    // 256 bins per channel and for the gray plane, empty unless the image is 8 bit
+    std::vector<std::vector<long long>> channelHistograms;
+    std::vector<long long> grayHistogram;
+    // Per channel
+    std::vector<double> minimum;
+    std::vector<double> maximum;
+    std::vector<double> mean;
+    std::vector<double> stddev;
+    // Shannon entropy of the gray plane in bits per pixel
+    double entropy = 0;
+};
+
+// Histogram of any rectangle of an 8 bit gray plane without scanning all of it. Cumulative 256 bin
+// histograms over a grid of blockSize blocks answer the whole blocks inside the rectangle in
+// O(256), only the partial blocks along its border are counted from the pixels.
+class IntegralHistogram
+{
+public:
+    IntegralHistogram() = default;
+    explicit IntegralHistogram(const cv::Mat &gray, int blockSize = 64);
+
+    bool empty() const;
+    std::vector<long long> histogram(cv::Rect region) const;
+    // Follows a point operation applied to the gray plane, the pixels aren't read again
+    void remap(const cv::Mat &lut);
+
+private:
+    int cellIndex(int gridRow, int gridCol) const;
+
+    cv::Mat gray;
+    // gray levels of gray go through lut before being counted
+    cv::Mat lut;
+    int blockSize = 64;
+    int gridRows = 0;
+    int gridCols = 0;
+    // (gridRows + 1) x (gridCols + 1) cells of 256 counts, a cell counts the blocks above and left of it
+    std::vector<uint32_t> cumulative;
+};
+
+// Gray plane without copying single channel images
+cv::Mat grayPlaneOf(const cv::Mat &image);
+// gray: grayPlaneOf(image) when it is already known, derived if needed otherwise
+ImageAnalytics computeImageAnalytics(const cv::Mat &image, cv::Mat gray = cv::Mat());
+// Plot of the 256 bin histograms, one curve per channel
+cv::Mat histogramImage(const std::vector<std::vector<long long>> &histograms, int height = 200);
+
+#endif // IMAGE_ANALYTICS_H
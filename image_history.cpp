@@ -0,0 +1,383 @@
+#include "image_history.h"
+#include <algorithm>
+#include <set>
+
+using namespace cv;
+using namespace std;
+
+static bool encodePixels(const Mat &pixels, vector<uchar> &encoded)
+{
+    if (pixels.depth() != CV_8U && pixels.depth() != CV_16U)
+        return false;
+
+    // Lowest compression level, the history is compressed on every submit
+    return imencode(".png", pixels, encoded, {IMWRITE_PNG_COMPRESSION, 1});
+}
+
+static size_t matBytes(const Mat &mat)
+{
+    return mat.empty() ? 0 : mat.total() * mat.elemSize();
+}
+
+ImageHistory::ImageHistory(size_t byteBudget, int tileSize, int uncompressedEntries, int keyframeInterval)
+    : budget(byteBudget),
+      tileSize(max(16, tileSize)),
+      uncompressedEntries(max(1, uncompressedEntries)),
+      keyframeInterval(max(1, keyframeInterval))
+{
+}
+
+void ImageHistory::reset(const Mat &original)
+{
+    entries.clear();
+    invalidateCache();
+
+    HistoryEntry entry;
+    entry.image = original.clone();
+    entry.size = original.size();
+    entry.type = original.type();
+    entry.isKeyframe = true;
+    entry.id = nextId++;
+    entries.push_back(entry);
+}
+
+void ImageHistory::push(const Mat &image, const ImageOperation &operation)
+{
+    if (entries.empty())
+    {
+        reset(image);
+        return;
+    }
+
+    HistoryEntry entry = makeEntry(entries.back().image, image, true);
+    entry.operation = operation;
+    entry.id = nextId++;
+    // an edit that changed nothing shares the pixels, and so the analytics, of the previous revision
+    if (!entry.image.empty() && entry.image.datastart == entries.back().image.datastart)
+    {
+        entry.gray = entries.back().gray;
+        entry.analytics = entries.back().analytics;
+        entry.pyramid = entries.back().pyramid;
+    }
+    entries.push_back(entry);
+    compressOldEntries();
+    evictOverBudget();
+}
+
+void ImageHistory::truncateAfter(int index)
+{
+    if (index + 1 < (int)entries.size())
+    {
+        entries.erase(entries.begin() + index + 1, entries.end());
+        invalidateCache();
+    }
+}
+
+Mat ImageHistory::at(int index) const
+{
+    const HistoryEntry &entry = entries.at(index);
+
+    if (!entry.image.empty())
+        return entry.image;
+
+    if (index == cachedIndex)
+        return cachedImage;
+
+    Mat result;
+    if (isPointRevision(index))
+    {
+        // a run of point operations is rebuilt from the composed table in one pass
+        int first = index;
+        while (first - 1 != cachedIndex && isPointRevision(first - 1))
+            first--;
+
+        vector<ImageOperation> operations;
+        for (int i = first; i <= index; i++)
+        {
+            operations.push_back(entries[i].operation);
+        }
+        result = applyPointOperations(at(first - 1), operations);
+    }
+    else if (entry.isOperationOnly)
+    {
+        result = applyOperation(at(index - 1), entry.operation);
+    }
+    else if (entry.isKeyframe)
+    {
+        result = imdecode(entry.encodedImage, IMREAD_UNCHANGED);
+    }
+    else
+    {
+        // Replay the changed tiles on top of the previous revision
+        result = at(index - 1).clone();
+        for (const HistoryTile &tile : entry.tiles)
+        {
+            if (!tile.pixels.empty())
+                tile.pixels.copyTo(result(tile.rect));
+            else
+                imdecode(tile.encoded, IMREAD_UNCHANGED).copyTo(result(tile.rect));
+        }
+    }
+
+    cachedIndex = index;
+    cachedImage = result;
+    return result;
+}
+
+Size ImageHistory::imageSize(int index) const
+{
+    return entries.at(index).size;
+}
+
+Mat ImageHistory::grayPlane(int index) const
+{
+    const HistoryEntry &entry = entries.at(index);
+
+    if (entry.gray.empty())
+        entry.gray = grayPlaneOf(at(index));
+
+    return entry.gray;
+}
+
+shared_ptr<const ImageAnalytics> ImageHistory::analytics(int index) const
+{
+    const HistoryEntry &entry = entries.at(index);
+
+    // the gray histogram of a colour revision reuses its gray plane if a tool already derived it
+    if (!entry.analytics)
+        entry.analytics = make_shared<ImageAnalytics>(computeImageAnalytics(at(index), entry.gray));
+
+    return entry.analytics;
+}
+
+shared_ptr<const ImagePyramid> ImageHistory::pyramid(int index) const
+{
+    const HistoryEntry &entry = entries.at(index);
+
+    if (!entry.pyramid)
+        entry.pyramid = make_shared<ImagePyramid>(at(index));
+
+    return entry.pyramid;
+}
+
+unsigned long long ImageHistory::revisionId(int index) const
+{
+    return entries.at(index).id;
+}
+
+vector<ImageOperation> ImageHistory::operationLog(int index) const
+{
+    vector<ImageOperation> operations;
+    for (int i = 1; i <= index && i < (int)entries.size(); i++)
+    {
+        operations.push_back(entries[i].operation);
+    }
+    return operations;
+}
+
+int ImageHistory::size() const
+{
+    return entries.size();
+}
+
+bool ImageHistory::empty() const
+{
+    return entries.empty();
+}
+
+size_t ImageHistory::byteSize() const
+{
+    size_t total = 0;
+    set<const uchar *> countedBuffers;
+
+    for (const HistoryEntry &entry : entries)
+    {
+        // entries that share a buffer are only counted once
+        if (!entry.image.empty() && countedBuffers.insert(entry.image.datastart).second)
+            total += matBytes(entry.image);
+        if (!entry.gray.empty() && countedBuffers.insert(entry.gray.datastart).second)
+            total += matBytes(entry.gray);
+        // level 0 is the image itself
+        for (int level = 1; entry.pyramid && level < entry.pyramid->levels(); level++)
+        {
+            if (countedBuffers.insert(entry.pyramid->level(level).datastart).second)
+                total += matBytes(entry.pyramid->level(level));
+        }
+
+        total += entry.encodedImage.size();
+        for (const HistoryTile &tile : entry.tiles)
+            total += tile.encoded.size() + matBytes(tile.pixels);
+    }
+
+    return total;
+}
+
+size_t ImageHistory::byteBudget() const
+{
+    return budget;
+}
+
+void ImageHistory::setByteBudget(size_t byteBudget)
+{
+    budget = byteBudget;
+    evictOverBudget();
+}
+
+HistoryEntry ImageHistory::makeEntry(const Mat &previous, const Mat &image, bool copyPixels) const
+{
+    HistoryEntry entry;
+    entry.size = image.size();
+    entry.type = image.type();
+
+    if (previous.empty() || previous.size() != image.size() || previous.type() != image.type())
+    {
+        entry.image = copyPixels ? image.clone() : image;
+        entry.isKeyframe = true;
+        return entry;
+    }
+
+    vector<Rect> changed = changedTiles(previous, image);
+    for (const Rect &rect : changed)
+    {
+        HistoryTile tile;
+        tile.rect = rect;
+        entry.tiles.push_back(tile);
+    }
+
+    // nothing changed, share the previous buffer instead of holding a second copy
+    if (changed.empty())
+        entry.image = previous;
+    else
+        entry.image = copyPixels ? image.clone() : image;
+
+    return entry;
+}
+
+vector<Rect> ImageHistory::changedTiles(const Mat &previous, const Mat &image) const
+{
+    vector<Rect> rects;
+
+    for (int y = 0; y < image.rows; y += tileSize)
+    {
+        for (int x = 0; x < image.cols; x += tileSize)
+        {
+            Rect rect(x, y, min(tileSize, image.cols - x), min(tileSize, image.rows - y));
+            if (norm(previous(rect), image(rect), NORM_INF) > 0)
+            {
+                rects.push_back(rect);
+            }
+        }
+    }
+
+    return rects;
+}
+
+bool ImageHistory::isPointRevision(int index) const
+{
+    return index > 0 && entries[index].isOperationOnly && isPointOperation(entries[index].operation);
+}
+
+int ImageHistory::distanceToKeyframe(int index) const
+{
+    // revisions replayed by at(), a run of point operations is a single pass
+    int distance = 0;
+    while (index > 0 && !entries[index].isKeyframe)
+    {
+        if (!(isPointRevision(index) && isPointRevision(index - 1)))
+            distance++;
+        index--;
+    }
+    return distance;
+}
+
+void ImageHistory::compress(int index)
+{
+    HistoryEntry &entry = entries[index];
+    if (entry.isCompressed)
+        return;
+
+    // a third of the pixels again, rebuilt if the revision is previewed
+    entry.pyramid.reset();
+
+    // the statistics are small and stay, the gray plane would keep a third of the pixels alive
+    entry.gray.release();
+
+    // the operation is enough to rebuild the revision until the next keyframe is due, a point
+    // operation following another one joins its pass
+    int distance = distanceToKeyframe(index - 1);
+    if (!(isPointOperation(entry.operation) && isPointRevision(index - 1)))
+        distance++;
+
+    if (isReplayable(entry.operation) && distance < keyframeInterval)
+    {
+        entry.image.release();
+        entry.tiles.clear();
+        entry.isKeyframe = false;
+        entry.isOperationOnly = true;
+        entry.isCompressed = true;
+        return;
+    }
+
+    // bound the number of deltas replayed by at()
+    if (!entry.isKeyframe && distanceToKeyframe(index) >= keyframeInterval)
+    {
+        entry.isKeyframe = true;
+        entry.tiles.clear();
+    }
+
+    if (entry.isKeyframe)
+    {
+        // keep the raw pixels if the depth can't be encoded
+        if (encodePixels(entry.image, entry.encodedImage))
+            entry.image.release();
+    }
+    else
+    {
+        for (HistoryTile &tile : entry.tiles)
+        {
+            Mat pixels = entry.image(tile.rect);
+            if (!encodePixels(pixels, tile.encoded))
+                tile.pixels = pixels.clone();
+        }
+        entry.image.release();
+    }
+
+    entry.isCompressed = true;
+}
+
+void ImageHistory::compressOldEntries()
+{
+    // The base image stays uncompressed, reset and show diff read it directly
+    int lastToCompress = (int)entries.size() - uncompressedEntries;
+    for (int i = 1; i < lastToCompress; i++)
+    {
+        compress(i);
+    }
+}
+
+void ImageHistory::evictOverBudget()
+{
+    // Always keep the base image and the newest revision
+    while (entries.size() > 2 && byteSize() > budget)
+    {
+        Mat next = at(2);
+        bool wasCompressed = entries[2].isCompressed;
+        unsigned long long id = entries[2].id;
+
+        entries.erase(entries.begin() + 1);
+        invalidateCache();
+
+        // the entry that followed the evicted one is re-encoded against the base, its operation
+        // no longer applies to the previous revision so it can't be replayed
+        entries[1] = makeEntry(entries[0].image, next, false);
+        entries[1].id = id;
+        if (wasCompressed)
+            compress(1);
+    }
+}
+
+void ImageHistory::invalidateCache()
+{
+    cachedIndex = -1;
+    cachedImage.release();
+}
@@ -0,0 +1,110 @@
+#ifndef IMAGE_HISTORY_H
+#define IMAGE_HISTORY_H
+
+#include "image_analytics.h"
+#include "image_operation.h"
+#include "image_pyramid.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+struct HistoryTile
+{
+    cv::Rect rect;
+    // PNG encoded pixels of the tile, filled once the entry gets compressed
+    std::vector<uchar> encoded;
+    // raw fallback for depths that PNG can't hold
+    cv::Mat pixels;
+};
+
+struct HistoryEntry
+{
+    // Full pixels of the revision, shared with the previous entry when nothing changed
+    cv::Mat image;
+    // Tiles that differ from the previous revision (empty for keyframes)
+    std::vector<HistoryTile> tiles;
+    // Whole revision PNG encoded, used by compressed keyframes
+    std::vector<uchar> encodedImage;
+    // The edit that produced this revision from the previous one
+    ImageOperation operation;
+    cv::Size size;
+    int type = 0;
+    bool isKeyframe = false;
+    bool isCompressed = false;
+    // No pixels are stored, the revision is rebuilt by replaying operation
+    bool isOperationOnly = false;
+    // Computed on first use by ImageHistory::grayPlane(), shares the pixels of a single channel
+    // revision, dropped on compression
+    mutable cv::Mat gray;
+    // Computed on first use by ImageHistory::analytics(), kept on compression
+    mutable std::shared_ptr<const ImageAnalytics> analytics;
+    // Computed on first use by ImageHistory::pyramid(), dropped on compression
+    mutable std::shared_ptr<const ImagePyramid> pyramid;
+    // Never reused by the store, unlike the index, which shifts when older entries are evicted
+    unsigned long long id = 0;
+};
+
+// Undo/redo store with a byte budget.
+// The base image (index 0) and the newest entries are kept as plain Mats. Older entries that
+// recorded a replayable operation only keep the operation, with a full keyframe every
+// keyframeInterval steps (a run of point operations replays as one composed table and counts
+// as one step), the others are compressed to PNG encoded tile deltas against the
+// previous revision. The oldest entries are evicted once the store goes over budget. Mats
+// returned by at() may share memory with the store, treat them as read-only and copyTo() before
+// editing.
+class ImageHistory
+{
+public:
+    static constexpr size_t defaultByteBudget = size_t(512) * 1024 * 1024;
+
+    explicit ImageHistory(size_t byteBudget = defaultByteBudget, int tileSize = 256, int uncompressedEntries = 2, int keyframeInterval = 8);
+
+    void reset(const cv::Mat &original);
+    void push(const cv::Mat &image, const ImageOperation &operation = ImageOperation());
+    void truncateAfter(int index);
+    cv::Mat at(int index) const;
+    // Size of revision index without rebuilding its pixels
+    cv::Size imageSize(int index) const;
+    // Operations that lead from the base image to revision index, an operation that is not
+    // replayable means the log can't reproduce that revision
+    std::vector<ImageOperation> operationLog(int index) const;
+    // Gray plane the gray level tools work on, derived once per revision. Read only.
+    cv::Mat grayPlane(int index) const;
+    // Histograms and statistics of revision index, only computed when a tool asks for them
+    std::shared_ptr<const ImageAnalytics> analytics(int index) const;
+    // Mipmaps of revision index the interactive tools preview from, built once per revision
+    std::shared_ptr<const ImagePyramid> pyramid(int index) const;
+    // Identifies revision index for caches kept outside the store, see HistoryEntry::id
+    unsigned long long revisionId(int index) const;
+
+    int size() const;
+    bool empty() const;
+    size_t byteSize() const;
+    size_t byteBudget() const;
+    void setByteBudget(size_t byteBudget);
+
+private:
+    HistoryEntry makeEntry(const cv::Mat &previous, const cv::Mat &image, bool copyPixels) const;
+    std::vector<cv::Rect> changedTiles(const cv::Mat &previous, const cv::Mat &image) const;
+    // operation only revision of a point operation, runs of them are replayed as one table
+    bool isPointRevision(int index) const;
+    int distanceToKeyframe(int index) const;
+    void compress(int index);
+    void compressOldEntries();
+    void evictOverBudget();
+    void invalidateCache();
+
+    std::vector<HistoryEntry> entries;
+    size_t budget;
+    int tileSize;
+    int uncompressedEntries;
+    int keyframeInterval;
+    unsigned long long nextId = 1;
+
+    // Last revision rebuilt by at(), makes redo after undo a single replay
+    mutable int cachedIndex = -1;
+    mutable cv::Mat cachedImage;
+};
+
+#endif // IMAGE_HISTORY_H
@@ -0,0 +1,783 @@
+#include "image_operation.h"
+#include "canny_edges.h"
+#include "image_processing.h"
+#include "point_lut.h"
+#include "scale_space.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+bool isReplayable(const ImageOperation &operation)
+{
+    return operation.type != OperationType::None;
+}
+
+Mat applyOperation(const Mat &image, const ImageOperation &operation)
+{
+    Mat dstImage;
+
+    switch (operation.type)
+    {
+    case OperationType::ConvertToGray:
+        dstImage = grayscaleOf(image);
+        break;
+    case OperationType::Flip:
+        dstImage = flipImage(image, operation.option);
+        break;
+    case OperationType::HistogramEqualization:
+        dstImage = equalizeHistogram(grayscaleOf(image));
+        break;
+    case OperationType::Negative:
+        dstImage = negativeImage(grayscaleOf(image));
+        break;
+    case OperationType::LogTransformation:
+        dstImage = logTransformation(grayscaleOf(image));
+        break;
+    case OperationType::BitSlicing:
+        dstImage = bitSlicing(grayscaleOf(image));
+        break;
+    case OperationType::Brightness:
+        dstImage = gammaBrightness(grayscaleOf(image), operation.values.at(0));
+        break;
+    case OperationType::Median:
+        dstImage = medianFilter(operation.option == 1 ? image : grayscaleOf(image), operation.values.empty() ? 3 : (int)operation.values.at(0));
+        break;
+    case OperationType::Sobel:
+        dstImage = sobelEdges(grayscaleOf(image), (SobelOrientation)operation.option);
+        break;
+    case OperationType::LaplacianOfGaussian:
+        if (operation.values.empty())
+            dstImage = laplacianOfGaussian(grayscaleOf(image));
+        else
+            dstImage = laplacianEdges(grayscaleOf(image), vector<double>(operation.values.begin() + 1, operation.values.end()), operation.values.at(0));
+        break;
+    case OperationType::Canny:
+        dstImage = cannyEdges(grayscaleOf(image), operation.values.at(0), operation.values.at(1));
+        break;
+    case OperationType::Segmentation:
+    {
+        Mat gray = grayscaleOf(image);
+        int t0 = operation.values.empty() ? automaticThreshold(gray) : (int)operation.values.at(0);
+        dstImage = thresholdSegmentation(gray, t0);
+        break;
+    }
+    case OperationType::FrequencyDomain:
+        dstImage = frequencyDomainFilter(grayscaleOf(image), frequencyFilterOf(operation));
+        break;
+    case OperationType::AreaOfInterest:
+        // every click slices the result of the previous one
+        dstImage = applyLut(grayscaleOf(image), pointOperationLut(operation, {}));
+        break;
+    case OperationType::Smoothing:
+    {
+        Mat kernel = smoothingKernel((SmoothingLevel)operation.option);
+        if (operation.regions.empty())
+        {
+            dstImage = smoothRegion(image, kernel, Rect(0, 0, image.cols, image.rows));
+            break;
+        }
+
+        // every region reads the result of the previous ones
+        dstImage = image.clone();
+        Mat buffer;
+        for (const Rect &region : operation.regions)
+        {
+            smoothRegionInPlace(dstImage, kernel, region, buffer);
+        }
+        break;
+    }
+    case OperationType::Affine:
+        dstImage = affineTransform(image, operation.matrix);
+        break;
+    case OperationType::Zoom:
+        dstImage = image;
+        for (const Rect &region : operation.regions)
+        {
+            // a recipe may replay the zoom on an image smaller than the one it was recorded on
+            Rect inside = region & Rect(0, 0, dstImage.cols, dstImage.rows);
+            if (inside.empty())
+                CV_Error(Error::StsOutOfRange, formatOperation(operation) + " lies outside the " + to_string(dstImage.cols) + "x" + to_string(dstImage.rows) + " image");
+            dstImage = zoomRegion(dstImage, inside);
+        }
+        if (dstImage.data == image.data)
+            dstImage = image.clone();
+        break;
+    case OperationType::Crop:
+    {
+        Rect inside = operation.regions.at(0) & Rect(0, 0, image.cols, image.rows);
+        if (inside.empty())
+            CV_Error(Error::StsOutOfRange, formatOperation(operation) + " lies outside the " + to_string(image.cols) + "x" + to_string(image.rows) + " image");
+        dstImage = cropRegion(image, inside);
+        break;
+    }
+    case OperationType::None:
+    default:
+        dstImage = image.clone();
+        break;
+    }
+
+    // Same conversion onImageProcessingSubmit does before storing a revision
+    if (dstImage.type() == CV_32FC1)
+    {
+        dstImage.convertTo(dstImage, CV_8UC1, 255.0);
+    }
+
+    return dstImage;
+}
+
+Mat replayOperations(const Mat &image, const vector<ImageOperation> &operations)
+{
+    Mat dstImage = image.clone();
+    for (const ImageOperation &operation : operations)
+    {
+        dstImage = applyOperation(dstImage, operation);
+    }
+    return dstImage;
+}
+
+bool isPointOperation(const ImageOperation &operation)
+{
+    switch (operation.type)
+    {
+    case OperationType::ConvertToGray:
+    case OperationType::HistogramEqualization:
+    case OperationType::Negative:
+    case OperationType::LogTransformation:
+    case OperationType::BitSlicing:
+    case OperationType::Brightness:
+    case OperationType::Segmentation:
+    case OperationType::AreaOfInterest:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Mat pointOperationLut(const ImageOperation &operation, const vector<long long> &histogram)
+{
+    switch (operation.type)
+    {
+    case OperationType::HistogramEqualization:
+        return equalizeLut(histogram);
+    case OperationType::Negative:
+        return negativeLut();
+    case OperationType::LogTransformation:
+        return logLut(histogram);
+    case OperationType::BitSlicing:
+        return bitSlicingLut();
+    case OperationType::Brightness:
+        return gammaLut(operation.values.at(0), histogram);
+    case OperationType::Segmentation:
+        return thresholdLut(operation.values.empty() ? histogramMean(histogram) : (int)operation.values.at(0));
+    case OperationType::AreaOfInterest:
+    {
+        Mat lut = identityLut();
+        for (size_t i = 0; i + 1 < operation.values.size(); i += 2)
+        {
+            lut = composeLuts(lut, grayLevelSlicingLut(operation.values[i], operation.values[i + 1], operation.option == 1));
+        }
+        return lut;
+    }
+    case OperationType::ConvertToGray:
+    default:
+        return identityLut();
+    }
+}
+
+static bool needsHistogram(const ImageOperation &operation)
+{
+    switch (operation.type)
+    {
+    case OperationType::HistogramEqualization:
+    case OperationType::LogTransformation:
+    case OperationType::Brightness:
+        return true;
+    case OperationType::Segmentation:
+        return operation.values.empty();
+    default:
+        return false;
+    }
+}
+
+Mat compilePointOperations(const vector<ImageOperation> &operations, vector<long long> &histogram)
+{
+    // the histogram of every intermediate result follows from the previous one through its table
+    Mat lut = identityLut();
+    for (const ImageOperation &operation : operations)
+    {
+        Mat operationLut = pointOperationLut(operation, histogram);
+        lut = composeLuts(lut, operationLut);
+        histogram = remapHistogram(histogram, operationLut);
+    }
+    return lut;
+}
+
+Mat applyPointOperations(const Mat &image, const vector<ImageOperation> &operations)
+{
+    // the gray plane is derived once for the whole chain
+    Mat gray = image;
+    if (image.channels() != 1)
+        cvtColor(image, gray, COLOR_RGB2GRAY);
+
+    if (gray.depth() != CV_8U)
+        return replayOperations(image, operations);
+
+    // the pixels are read once for the histogram (only if a step normalizes) and once for the table
+    vector<long long> histogram(256, 0);
+    for (const ImageOperation &operation : operations)
+    {
+        if (needsHistogram(operation))
+        {
+            histogram = grayHistogram(gray);
+            break;
+        }
+    }
+
+    return applyLut(gray, compilePointOperations(operations, histogram));
+}
+
+bool isGeometryOperation(const ImageOperation &operation)
+{
+    return operation.type == OperationType::Flip || operation.type == OperationType::Affine;
+}
+
+Mat composeGeometryOperations(const vector<ImageOperation> &operations, Size size)
+{
+    Mat composed = Mat::eye(2, 3, CV_64F);
+    for (const ImageOperation &operation : operations)
+    {
+        composed = composeAffine(composed, operation.type == OperationType::Flip ? flipMatrix(operation.option, size) : operation.matrix);
+    }
+    return composed;
+}
+
+Mat applyGeometryOperations(const Mat &image, const vector<ImageOperation> &operations)
+{
+    bool hasAffine = false;
+    for (const ImageOperation &operation : operations)
+    {
+        hasAffine = hasAffine || operation.type == OperationType::Affine;
+    }
+
+    // flips alone cancel out or reduce to a single exact flip
+    if (!hasAffine)
+    {
+        bool flipX = false;
+        bool flipY = false;
+        for (const ImageOperation &operation : operations)
+        {
+            flipX ^= operation.option == 1 || operation.option == -1;
+            flipY ^= operation.option == 0 || operation.option == -1;
+        }
+
+        if (flipX && flipY)
+            return flipImage(image, -1);
+        if (flipX)
+            return flipImage(image, 1);
+        if (flipY)
+            return flipImage(image, 0);
+        return image.clone();
+    }
+
+    // otherwise compose everything into one warp so the image is resampled once
+    return affineTransform(image, composeGeometryOperations(operations, image.size()));
+}
+
+FrequencyFilter frequencyFilterOf(const ImageOperation &operation)
+{
+    FrequencyFilter filter;
+    filter.band = (FrequencyBand)operation.option;
+    const vector<double> &values = operation.values;
+    if (values.size() > 0)
+        filter.d0 = values[0];
+    if (values.size() > 1)
+        filter.shape = (FrequencyFilterShape)(int)values[1];
+    if (values.size() > 2)
+        filter.order = (int)values[2];
+    if (values.size() > 3)
+        filter.width = values[3];
+    return filter;
+}
+
+ImageOperation frequencyDomainOperation(const FrequencyFilter &filter)
+{
+    return {OperationType::FrequencyDomain, (int)filter.band, {filter.d0, (double)filter.shape, (double)filter.order, filter.width}};
+}
+
+static string trim(const string &text)
+{
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == string::npos)
+        return "";
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+// "t0=80, auto" -> {"80", "auto"}, the key only documents the argument
+static vector<string> splitArguments(const string &text)
+{
+    vector<string> arguments;
+    stringstream stream(text);
+    string argument;
+
+    while (getline(stream, argument, ','))
+    {
+        size_t equals = argument.find('=');
+        if (equals != string::npos)
+            argument = argument.substr(equals + 1);
+
+        argument = trim(argument);
+        if (!argument.empty())
+            arguments.push_back(argument);
+    }
+
+    return arguments;
+}
+
+static bool parseNumber(const string &text, double &value)
+{
+    char *end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0';
+}
+
+// "x:y:w:h" or "from:to"
+static bool parseNumbers(const string &text, size_t count, vector<double> &values)
+{
+    stringstream stream(text);
+    string part;
+    values.clear();
+
+    while (getline(stream, part, ':'))
+    {
+        double value;
+        if (!parseNumber(trim(part), value))
+            return false;
+        values.push_back(value);
+    }
+
+    return values.size() == count;
+}
+
+static string formatNumber(double value)
+{
+    ostringstream stream;
+    stream.precision(15);
+    stream << value;
+    return stream.str();
+}
+
+static string formatRect(const Rect &rect)
+{
+    return to_string(rect.x) + ":" + to_string(rect.y) + ":" + to_string(rect.width) + ":" + to_string(rect.height);
+}
+
+bool parseOperation(const string &text, ImageOperation &operation, string &error)
+{
+    string trimmed = trim(text);
+    string name = trimmed;
+    vector<string> arguments;
+
+    size_t open = trimmed.find('(');
+    if (open != string::npos)
+    {
+        if (trimmed.back() != ')')
+        {
+            error = "missing ')' in \"" + trimmed + "\"";
+            return false;
+        }
+        name = trim(trimmed.substr(0, open));
+        arguments = splitArguments(trimmed.substr(open + 1, trimmed.size() - open - 2));
+    }
+    else
+    {
+        // "median3" is a shorthand for "median(3)"
+        size_t lastLetter = name.find_last_not_of("0123456789");
+        if (lastLetter != string::npos && lastLetter + 1 < name.size())
+        {
+            arguments.push_back(name.substr(lastLetter + 1));
+            name = name.substr(0, lastLetter + 1);
+        }
+    }
+
+    transform(name.begin(), name.end(), name.begin(), ::tolower);
+    operation = ImageOperation();
+
+    auto numberAt = [&](size_t index, double &value) -> bool
+    {
+        if (index >= arguments.size() || !parseNumber(arguments[index], value))
+        {
+            error = "\"" + name + "\" expects a number as argument " + to_string(index + 1);
+            return false;
+        }
+        return true;
+    };
+
+    auto rectAt = [&](size_t index, Rect &rect) -> bool
+    {
+        vector<double> values;
+        if (!parseNumbers(arguments[index], 4, values))
+        {
+            error = "\"" + name + "\" expects regions as x:y:width:height";
+            return false;
+        }
+        rect = Rect(values[0], values[1], values[2], values[3]);
+        return true;
+    };
+
+    double value = 0;
+
+    if (name == "grayscale" || name == "gray")
+    {
+        operation.type = OperationType::ConvertToGray;
+    }
+    else if (name == "flip")
+    {
+        operation.type = OperationType::Flip;
+        string option = arguments.empty() ? "horizontal" : arguments[0];
+        if (option == "horizontal")
+            operation.option = 0;
+        else if (option == "vertical")
+            operation.option = 1;
+        else if (option == "both")
+            operation.option = -1;
+        else if (numberAt(0, value) && value >= -1 && value <= 1)
+            operation.option = value;
+        else
+        {
+            error = "flip expects horizontal, vertical or both";
+            return false;
+        }
+    }
+    else if (name == "equalize")
+    {
+        operation.type = OperationType::HistogramEqualization;
+    }
+    else if (name == "negative")
+    {
+        operation.type = OperationType::Negative;
+    }
+    else if (name == "log")
+    {
+        operation.type = OperationType::LogTransformation;
+    }
+    else if (name == "bitslice")
+    {
+        operation.type = OperationType::BitSlicing;
+    }
+    else if (name == "gamma")
+    {
+        operation.type = OperationType::Brightness;
+        if (!numberAt(0, value))
+            return false;
+        operation.values = {value};
+    }
+    else if (name == "median")
+    {
+        operation.type = OperationType::Median;
+        value = 3;
+        if (!arguments.empty() && !numberAt(0, value))
+            return false;
+        if (value < 3 || value > 101 || (int)value % 2 == 0)
+        {
+            error = "median expects an odd size between 3 and 101";
+            return false;
+        }
+        operation.values = {value};
+        if (arguments.size() > 1)
+        {
+            if (arguments[1] != "colour")
+            {
+                error = "median expects colour as second argument";
+                return false;
+            }
+            operation.option = 1;
+        }
+    }
+    else if (name == "sobel")
+    {
+        operation.type = OperationType::Sobel;
+        string option = arguments.empty() ? "both" : arguments[0];
+        if (option == "horizontal")
+            operation.option = (int)SobelOrientation::Horizontal;
+        else if (option == "vertical")
+            operation.option = (int)SobelOrientation::Vertical;
+        else if (option == "both")
+            operation.option = (int)SobelOrientation::Both;
+        else if (option == "direction")
+            operation.option = (int)SobelOrientation::Direction;
+        else
+        {
+            error = "sobel expects horizontal, vertical, both or direction";
+            return false;
+        }
+    }
+    else if (name == "laplacian")
+    {
+        operation.type = OperationType::LaplacianOfGaussian;
+        // no arguments is the fixed 5x5 kernel, otherwise the contrast and one or more sigmas
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+            if (!numberAt(i, value))
+                return false;
+            operation.values.push_back(value);
+        }
+        if (operation.values.size() == 1 || (!operation.values.empty() &&
+                                              (operation.values[0] < 0 || *min_element(operation.values.begin() + 1, operation.values.end()) <= 0)))
+        {
+            error = "laplacian expects a contrast of at least 0 followed by sigmas greater than 0";
+            return false;
+        }
+    }
+    else if (name == "canny")
+    {
+        operation.type = OperationType::Canny;
+        double high = 0;
+        if (!numberAt(0, value) || !numberAt(1, high))
+            return false;
+        if (value < 0 || high < value)
+        {
+            error = "canny expects 0 <= low <= high";
+            return false;
+        }
+        operation.values = {value, high};
+    }
+    else if (name == "threshold")
+    {
+        operation.type = OperationType::Segmentation;
+        if (!arguments.empty() && arguments[0] != "auto")
+        {
+            if (!numberAt(0, value))
+                return false;
+            operation.values = {value};
+        }
+    }
+    else if (name == "lowpass" || name == "highpass" || name == "bandpass" || name == "bandstop")
+    {
+        FrequencyFilter filter;
+        filter.band = name == "lowpass"    ? FrequencyBand::LowPass
+                      : name == "highpass" ? FrequencyBand::HighPass
+                      : name == "bandpass" ? FrequencyBand::BandPass
+                                           : FrequencyBand::BandStop;
+        bool isBand = filter.band == FrequencyBand::BandPass || filter.band == FrequencyBand::BandStop;
+        string usage = name + (isBand ? " expects d0, width" : " expects d0") + ", ideal|gaussian|butterworth and the butterworth order";
+
+        // d0, the width of a band and the order, in that order, the shape anywhere
+        vector<double> numbers;
+        for (const string &argument : arguments)
+        {
+            if (argument == "ideal")
+                filter.shape = FrequencyFilterShape::Ideal;
+            else if (argument == "gaussian")
+                filter.shape = FrequencyFilterShape::Gaussian;
+            else if (argument == "butterworth")
+                filter.shape = FrequencyFilterShape::Butterworth;
+            else if (parseNumber(argument, value))
+                numbers.push_back(value);
+            else
+            {
+                error = usage;
+                return false;
+            }
+        }
+
+        size_t next = 0;
+        if (next < numbers.size())
+            filter.d0 = numbers[next++];
+        if (isBand && next < numbers.size())
+            filter.width = numbers[next++];
+        if (next < numbers.size())
+            filter.order = (int)numbers[next++];
+        if (next < numbers.size() || filter.d0 <= 0 || filter.width <= 0 || filter.order < 1)
+        {
+            error = usage;
+            return false;
+        }
+
+        operation = frequencyDomainOperation(filter);
+    }
+    else if (name == "slice")
+    {
+        operation.type = OperationType::AreaOfInterest;
+        for (const string &argument : arguments)
+        {
+            if (argument == "keep")
+            {
+                operation.option = 1;
+                continue;
+            }
+
+            vector<double> range;
+            if (!parseNumbers(argument, 2, range))
+            {
+                error = "slice expects ranges as from:to";
+                return false;
+            }
+            operation.values.insert(operation.values.end(), range.begin(), range.end());
+        }
+    }
+    else if (name == "smooth")
+    {
+        operation.type = OperationType::Smoothing;
+        value = 1;
+        if (!arguments.empty() && !numberAt(0, value))
+            return false;
+        if (value < 1 || value > 4)
+        {
+            error = "smooth expects a level between 1 and 4";
+            return false;
+        }
+        operation.option = value;
+        for (size_t i = 1; i < arguments.size(); i++)
+        {
+            Rect region;
+            if (!rectAt(i, region))
+                return false;
+            operation.regions.push_back(region);
+        }
+    }
+    else if (name == "affine")
+    {
+        operation.type = OperationType::Affine;
+        operation.matrix = Mat(2, 3, CV_64F);
+        for (int i = 0; i < 6; i++)
+        {
+            if (!numberAt(i, value))
+                return false;
+            operation.matrix.at<double>(i / 3, i % 3) = value;
+        }
+    }
+    else if (name == "zoom")
+    {
+        operation.type = OperationType::Zoom;
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+            Rect region;
+            if (!rectAt(i, region))
+                return false;
+            operation.regions.push_back(region);
+        }
+    }
+    else if (name == "crop")
+    {
+        operation.type = OperationType::Crop;
+        Rect region;
+        if (arguments.size() != 1 || !rectAt(0, region) || region.empty())
+        {
+            error = "crop expects one non empty region as x:y:width:height";
+            return false;
+        }
+        operation.regions.push_back(region);
+    }
+    else
+    {
+        error = "unknown operation \"" + name + "\"";
+        return false;
+    }
+
+    return true;
+}
+
+string formatOperation(const ImageOperation &operation)
+{
+    switch (operation.type)
+    {
+    case OperationType::ConvertToGray:
+        return "grayscale";
+    case OperationType::Flip:
+        return operation.option == 0 ? "flip(horizontal)" : operation.option == 1 ? "flip(vertical)"
+                                                                                 : "flip(both)";
+    case OperationType::HistogramEqualization:
+        return "equalize";
+    case OperationType::Negative:
+        return "negative";
+    case OperationType::LogTransformation:
+        return "log";
+    case OperationType::BitSlicing:
+        return "bitslice";
+    case OperationType::Brightness:
+        return "gamma(" + formatNumber(operation.values.at(0)) + ")";
+    case OperationType::Median:
+        return "median(" + formatNumber(operation.values.empty() ? 3 : operation.values.at(0)) + (operation.option == 1 ? ", colour)" : ")");
+    case OperationType::Sobel:
+    {
+        static const char *orientationNames[] = {"horizontal", "vertical", "both", "direction"};
+        return string("sobel(") + orientationNames[operation.option] + ")";
+    }
+    case OperationType::LaplacianOfGaussian:
+    {
+        if (operation.values.empty())
+            return "laplacian";
+        string text = "laplacian(contrast=" + formatNumber(operation.values[0]) + ", sigma=";
+        for (size_t i = 1; i < operation.values.size(); i++)
+        {
+            text += (i > 1 ? ", " : "") + formatNumber(operation.values[i]);
+        }
+        return text + ")";
+    }
+    case OperationType::Canny:
+        return "canny(low=" + formatNumber(operation.values.at(0)) + ", high=" + formatNumber(operation.values.at(1)) + ")";
+    case OperationType::Segmentation:
+        return operation.values.empty() ? "threshold(auto)" : "threshold(t0=" + formatNumber(operation.values.at(0)) + ")";
+    case OperationType::FrequencyDomain:
+    {
+        FrequencyFilter filter = frequencyFilterOf(operation);
+        static const char *bandNames[] = {"highpass", "lowpass", "bandpass", "bandstop"};
+        string text = string(bandNames[(int)filter.band]) + "(d0=" + formatNumber(filter.d0);
+        if (filter.band == FrequencyBand::BandPass || filter.band == FrequencyBand::BandStop)
+            text += ", width=" + formatNumber(filter.width);
+        if (filter.shape == FrequencyFilterShape::Gaussian)
+            text += ", gaussian";
+        else if (filter.shape == FrequencyFilterShape::Butterworth)
+            text += ", butterworth, order=" + to_string(filter.order);
+        return text + ")";
+    }
+    case OperationType::AreaOfInterest:
+    {
+        string text = "slice(";
+        for (size_t i = 0; i + 1 < operation.values.size(); i += 2)
+        {
+            text += (i ? ", " : "") + formatNumber(operation.values[i]) + ":" + formatNumber(operation.values[i + 1]);
+        }
+        if (operation.option == 1)
+            text += operation.values.empty() ? "keep" : ", keep";
+        return text + ")";
+    }
+    case OperationType::Smoothing:
+    {
+        string text = "smooth(" + to_string(operation.option);
+        for (const Rect &region : operation.regions)
+        {
+            text += ", " + formatRect(region);
+        }
+        return text + ")";
+    }
+    case OperationType::Affine:
+    {
+        string text = "affine(";
+        for (int i = 0; i < 6; i++)
+        {
+            text += (i ? ", " : "") + formatNumber(operation.matrix.at<double>(i / 3, i % 3));
+        }
+        return text + ")";
+    }
+    case OperationType::Zoom:
+    {
+        string text = "zoom(";
+        for (size_t i = 0; i < operation.regions.size(); i++)
+        {
+            text += (i ? ", " : "") + formatRect(operation.regions[i]);
+        }
+        return text + ")";
+    }
+    case OperationType::Crop:
+        return "crop(" + formatRect(operation.regions.at(0)) + ")";
+    case OperationType::None:
+    default:
+        return "none";
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef IMAGE_OPERATION_H
+#define IMAGE_OPERATION_H
+
+#include "frequency_domain.h"
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+enum class OperationType
+{
+    None,
+    ConvertToGray,
+    Flip,
+    HistogramEqualization,
+    Negative,
+    LogTransformation,
+    BitSlicing,
+    Brightness,
+    Median,
+    Sobel,
+    LaplacianOfGaussian,
+    Segmentation,
+    FrequencyDomain,
+    AreaOfInterest,
+    Smoothing,
+    Affine,
+    Zoom,
+    Canny,
+    Crop
+};
+
+// A single edit and the parameters needed to redo it on any image.
+// option: flip code, SobelOrientation, SmoothingLevel, FrequencyBand, 1 to keep the gray levels
+//         outside the area of interest band or 1 for a median of every colour channel
+// values: t0 (automatic when empty), gamma, median size, [d0, FrequencyFilterShape, order, width] of
+//         a frequency filter (d0 alone is an ideal filter), the [low, high] Canny thresholds,
+//         [contrast, sigma...] of the Laplacian zero crossings (the fixed 5x5 kernel when empty), or
+//         the [from, to] pairs of each area of interest click
+// matrix: 2x3 affine matrix of translate, rotate and deskew
+// regions: zoom crops, the crop to view and smoothing brush strokes in the order they were applied, smoothing
+//          without regions covers the whole image
+struct ImageOperation
+{
+    OperationType type = OperationType::None;
+    int option = 0;
+    std::vector<double> values;
+    cv::Mat matrix;
+    std::vector<cv::Rect> regions;
+};
+
+bool isReplayable(const ImageOperation &operation);
+cv::Mat applyOperation(const cv::Mat &image, const ImageOperation &operation);
+cv::Mat replayOperations(const cv::Mat &image, const std::vector<ImageOperation> &operations);
+
+// Gray level operations whose output only depends on the input gray level and the input histogram
+bool isPointOperation(const ImageOperation &operation);
+// Lookup table of a point operation for an input with the given gray level histogram
+cv::Mat pointOperationLut(const ImageOperation &operation, const std::vector<long long> &histogram);
+// Composes consecutive point operations into one table. histogram is the gray level histogram
+// of their input and is advanced to the histogram of their output.
+cv::Mat compilePointOperations(const std::vector<ImageOperation> &operations, std::vector<long long> &histogram);
+// Gray plane of image through all the point operations in a single table pass
+cv::Mat applyPointOperations(const cv::Mat &image, const std::vector<ImageOperation> &operations);
+
+// Flips and affine warps, which compose into a single transform
+bool isGeometryOperation(const ImageOperation &operation);
+// 2x3 matrix of consecutive geometry operations on an image of the given size
+cv::Mat composeGeometryOperations(const std::vector<ImageOperation> &operations, cv::Size size);
+// Consecutive geometry operations with a single resampling, flips alone stay an exact flip
+cv::Mat applyGeometryOperations(const cv::Mat &image, const std::vector<ImageOperation> &operations);
+
+// Frequency filter parameters of a FrequencyDomain operation and back
+FrequencyFilter frequencyFilterOf(const ImageOperation &operation);
+ImageOperation frequencyDomainOperation(const FrequencyFilter &filter);
+
+// Text form used by the command line, e.g. "grayscale", "median(3)", "sobel(both)", "threshold(t0=80)"
+bool parseOperation(const std::string &text, ImageOperation &operation, std::string &error);
+std::string formatOperation(const ImageOperation &operation);
+
+#endif // IMAGE_OPERATION_H
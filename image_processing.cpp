@@ -0,0 +1,277 @@
+#include "image_processing.h"
+#include "fixed_kernels.h"
+#include "median_filter.h"
+#include "point_lut.h"
+#include "smoothing_filter.h"
+#include "sobel_gradient.h"
+
+using namespace cv;
+using namespace std;
+
+int imageDepth2Bits(int depth)
+{
+    switch (depth)
+    {
+    case CV_8U:
+    case CV_8S:
+        return 8;
+    case CV_16U:
+    case CV_16S:
+        return 16;
+    case CV_32S:
+    case CV_32F:
+        return 32;
+    case CV_64F:
+        return 64;
+    default:
+        return 0;
+    }
+}
+
+Mat grayscaleOf(const Mat &image)
+{
+    Mat gray;
+    if (image.channels() != 1)
+    {
+        cvtColor(image, gray, COLOR_RGB2GRAY);
+    }
+    else
+    {
+        image.copyTo(gray);
+    }
+    return gray;
+}
+
+Mat negativeImage(const Mat &gray)
+{
+    return applyLut(gray, negativeLut());
+}
+
+Mat logTransformation(const Mat &gray)
+{
+    return applyLut(gray, logLut(grayHistogram(gray)));
+}
+
+Mat bitSlicing(const Mat &gray)
+{
+    return applyLut(gray, bitSlicingLut());
+}
+
+Mat gammaBrightness(const Mat &gray, float gamma)
+{
+    return applyLut(gray, gammaLut(gamma, grayHistogram(gray)));
+}
+
+Mat equalizeHistogram(const Mat &gray)
+{
+    return applyLut(gray, equalizeLut(grayHistogram(gray)));
+}
+
+Mat thresholdSegmentation(const Mat &gray, int t0)
+{
+    return applyLut(gray, thresholdLut(t0));
+}
+
+int automaticThreshold(const Mat &gray)
+{
+    // t0 is the average gray level
+    return histogramMean(grayHistogram(gray));
+}
+
+pair<int, int> grayLevelRange(const vector<long long> &histogram)
+{
+    int rangeFrom = 255;
+    int rangeTo = 0;
+
+    long long totalSelectedPixels = 0;
+    for (long long count : histogram)
+        totalSelectedPixels += count;
+
+    // the band covers the gray levels holding more than 0.5% of the selection
+    for (int value = 0; value < 256; value++)
+    {
+        if (histogram[value] / (totalSelectedPixels * 1.0) > 0.005)
+        {
+            rangeFrom = min(rangeFrom, value);
+            rangeTo = max(rangeTo, value);
+        }
+    }
+
+    return make_pair(rangeFrom, rangeTo);
+}
+
+pair<int, int> grayLevelRange(const Mat &gray, Rect region)
+{
+    region &= Rect(0, 0, gray.cols, gray.rows);
+    if (region.empty())
+        return make_pair(255, 0);
+
+    return grayLevelRange(grayHistogram(gray(region)));
+}
+
+Mat grayLevelSlicing(const Mat &gray, int rangeFrom, int rangeTo, bool keepOutside)
+{
+    return applyLut(gray, grayLevelSlicingLut(rangeFrom, rangeTo, keepOutside));
+}
+
+Mat medianFilter(const Mat &image, int kernelSize)
+{
+    // the sorting networks of medianBlur win up to 5x5, above that the cost per pixel is constant
+    if (kernelSize <= 5)
+    {
+        Mat dstImage;
+        medianBlur(image, dstImage, kernelSize);
+        return dstImage;
+    }
+    return constantTimeMedian(image, kernelSize / 2);
+}
+
+Mat sobelEdges(const Mat &gray, SobelOrientation orientation)
+{
+    Mat dstImage;
+
+    // signed derivatives, falling edges are as strong as rising ones
+    if (orientation == SobelOrientation::Horizontal)
+    {
+        Sobel(gray, dstImage, CV_16SC1, 0, 1, 5);
+        convertScaleAbs(dstImage, dstImage);
+    }
+    else if (orientation == SobelOrientation::Vertical)
+    {
+        Sobel(gray, dstImage, CV_16SC1, 1, 0, 5);
+        convertScaleAbs(dstImage, dstImage);
+    }
+    else if (orientation == SobelOrientation::Direction)
+    {
+        Mat hsv[3];
+        sobelGradient(gray, hsv[2], GradientNorm::L2, &hsv[0]);
+        hsv[1] = Mat(gray.size(), CV_8UC1, Scalar(255));
+        merge(hsv, 3, dstImage);
+        cvtColor(dstImage, dstImage, COLOR_HSV2BGR);
+    }
+    else
+    {
+        sobelGradient(gray, dstImage, GradientNorm::L1);
+    }
+
+    return dstImage;
+}
+
+Mat laplacianOfGaussianKernel()
+{
+    return kernelOf(laplacianOfGaussianWeights5x5);
+}
+
+Mat laplacianOfGaussian(const Mat &gray)
+{
+    Mat dstImage;
+    if (!fixedKernelFilter(gray, dstImage, laplacianOfGaussianKernel()))
+        filter2D(gray, dstImage, CV_8UC1, laplacianOfGaussianKernel());
+    return dstImage;
+}
+
+Mat smoothingKernel(SmoothingLevel level)
+{
+    switch (level)
+    {
+    case SmoothingLevel::Traditional3x3:
+        return kernelOf(traditionalWeights3x3);
+    case SmoothingLevel::Pyramidal5x5:
+        return kernelOf(pyramidalWeights5x5);
+    case SmoothingLevel::Circular5x5:
+        return kernelOf(circularWeights5x5);
+    case SmoothingLevel::Cone5x5:
+    default:
+        return kernelOf(coneWeights5x5);
+    }
+}
+
+Mat smoothRegion(const Mat &image, const Mat &kernel, Rect region)
+{
+    Mat dstImage = image.clone();
+    Mat buffer;
+    smoothRegionInPlace(dstImage, kernel, region, buffer);
+    return dstImage;
+}
+
+void smoothRegionInPlace(Mat &image, const Mat &kernel, Rect region, Mat &buffer)
+{
+    region &= Rect(0, 0, image.cols, image.rows);
+    if (region.empty())
+        return;
+
+    // the kernel halo around a submatrix is read from the pixels of its parent, so only the region
+    // is filtered and the result is the same as filtering the whole image
+    smoothingFilter(image(region), buffer, kernel);
+    buffer.copyTo(image(region));
+}
+
+Mat previewProxy(const Mat &image, int maxSide)
+{
+    int longestSide = max(image.cols, image.rows);
+    if (longestSide <= maxSide)
+        return image;
+
+    Mat proxy;
+    double scale = (double)maxSide / longestSide;
+    resize(image, proxy, Size(), scale, scale, INTER_AREA);
+    return proxy;
+}
+
+Mat flipImage(const Mat &image, int flipCode)
+{
+    Mat dstImage;
+    flip(image, dstImage, flipCode);
+    return dstImage;
+}
+
+Mat flipMatrix(int flipCode, Size size)
+{
+    Mat matrix = Mat::eye(3, 3, CV_64F);
+    if (flipCode == 1 || flipCode == -1)
+    {
+        matrix.at<double>(0, 0) = -1;
+        matrix.at<double>(0, 2) = size.width - 1;
+    }
+    if (flipCode == 0 || flipCode == -1)
+    {
+        matrix.at<double>(1, 1) = -1;
+        matrix.at<double>(1, 2) = size.height - 1;
+    }
+    return matrix;
+}
+
+Mat composeAffine(const Mat &first, const Mat &second)
+{
+    Mat homogeneous[2];
+    const Mat *matrices[2] = {&first, &second};
+    for (int i = 0; i < 2; i++)
+    {
+        homogeneous[i] = Mat::eye(3, 3, CV_64F);
+        Mat affine;
+        matrices[i]->rowRange(0, 2).convertTo(affine, CV_64F);
+        affine.copyTo(homogeneous[i].rowRange(0, 2));
+    }
+
+    Mat composed = homogeneous[1] * homogeneous[0];
+    return composed.rowRange(0, 2).clone();
+}
+
+Mat affineTransform(const Mat &image, const Mat &matrix)
+{
+    Mat dstImage;
+    warpAffine(image, dstImage, matrix, image.size());
+    return dstImage;
+}
+
+Mat zoomRegion(const Mat &image, Rect region)
+{
+    Mat dstImage;
+    cv::resize(image(region), dstImage, Size(), 2, 2);
+    return dstImage;
+}
+
+Mat cropRegion(const Mat &image, Rect region)
+{
+    return image(region & Rect(0, 0, image.cols, image.rows)).clone();
+}
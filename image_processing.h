@@ -0,0 +1,76 @@
+#ifndef IMAGE_PROCESSING_H
+#define IMAGE_PROCESSING_H
+
+#include <opencv2/opencv.hpp>
+#include <utility>
+#include <vector>
+
+enum class SobelOrientation
+{
+    Horizontal,
+    Vertical,
+    Both,
+    // gradient direction as hue, magnitude as value
+    Direction
+};
+
+enum class SmoothingLevel
+{
+    Traditional3x3 = 1,
+    Pyramidal5x5,
+    Circular5x5,
+    Cone5x5
+};
+
+int imageDepth2Bits(int depth);
+
+// Gray plane used by every gray level operation, a copy when the image already is single channel
+cv::Mat grayscaleOf(const cv::Mat &image);
+
+// Point operations, expect the 8 bit gray plane and run as a single lookup table pass (see point_lut.h)
+cv::Mat negativeImage(const cv::Mat &gray);
+cv::Mat logTransformation(const cv::Mat &gray);
+cv::Mat bitSlicing(const cv::Mat &gray);
+cv::Mat gammaBrightness(const cv::Mat &gray, float gamma);
+cv::Mat equalizeHistogram(const cv::Mat &gray);
+cv::Mat thresholdSegmentation(const cv::Mat &gray, int t0);
+int automaticThreshold(const cv::Mat &gray);
+
+// Gray level slicing, the range is estimated from the gray levels inside region
+std::pair<int, int> grayLevelRange(const cv::Mat &gray, cv::Rect region);
+// Range of the gray levels holding more than 0.5% of a region histogram
+std::pair<int, int> grayLevelRange(const std::vector<long long> &histogram);
+// keepOutside leaves the gray levels outside the band as they are instead of setting them to 0
+cv::Mat grayLevelSlicing(const cv::Mat &gray, int rangeFrom, int rangeTo, bool keepOutside = false);
+
+// Median of every channel, kernelSize is odd and at most 101
+cv::Mat medianFilter(const cv::Mat &image, int kernelSize);
+
+// Neighbourhood operations, expect the gray plane
+cv::Mat sobelEdges(const cv::Mat &gray, SobelOrientation orientation);
+cv::Mat laplacianOfGaussian(const cv::Mat &gray);
+cv::Mat smoothingKernel(SmoothingLevel level);
+cv::Mat laplacianOfGaussianKernel();
+// Smooths only region, the rest of image is left untouched. Colour images stay in colour.
+cv::Mat smoothRegion(const cv::Mat &image, const cv::Mat &kernel, cv::Rect region);
+// Same in place, the cost is the region and not the image; buffer is reused between calls
+void smoothRegionInPlace(cv::Mat &image, const cv::Mat &kernel, cv::Rect region, cv::Mat &buffer);
+
+// Image scaled down so its longest side is at most maxSide, image itself when it already fits.
+// Interactive tools tune their parameters on it and run the full resolution operation on submit.
+cv::Mat previewProxy(const cv::Mat &image, int maxSide);
+
+// Geometry
+cv::Mat flipImage(const cv::Mat &image, int flipCode);
+cv::Mat affineTransform(const cv::Mat &image, const cv::Mat &matrix);
+// 3x3 matrix mapping every pixel to where flipImage puts it
+cv::Mat flipMatrix(int flipCode, cv::Size size);
+// 2x3 matrix of first followed by second, either of them 2x3 or 3x3, so a chain of transforms is
+// resampled once
+cv::Mat composeAffine(const cv::Mat &first, const cv::Mat &second);
+// Crops region and scales it up by 2
+cv::Mat zoomRegion(const cv::Mat &image, cv::Rect region);
+// Copy of the part of region inside the image
+cv::Mat cropRegion(const cv::Mat &image, cv::Rect region);
+
+#endif // IMAGE_PROCESSING_H
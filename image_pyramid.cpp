@@ -0,0 +1,95 @@
+#include "image_pyramid.h"
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+ImagePyramid::ImagePyramid(const Mat &image, int minimumSide)
+{
+    if (image.empty())
+        return;
+
+    pyramid.push_back(image);
+    while (min(pyramid.back().cols, pyramid.back().rows) / 2 >= minimumSide)
+    {
+        Mat next;
+        resize(pyramid.back(), next, Size((pyramid.back().cols + 1) / 2, (pyramid.back().rows + 1) / 2), 0, 0, INTER_AREA);
+        pyramid.push_back(next);
+    }
+}
+
+bool ImagePyramid::empty() const
+{
+    return pyramid.empty();
+}
+
+int ImagePyramid::levels() const
+{
+    return (int)pyramid.size();
+}
+
+const Mat &ImagePyramid::level(int index) const
+{
+    return pyramid.at(index);
+}
+
+Size ImagePyramid::size() const
+{
+    return empty() ? Size() : pyramid[0].size();
+}
+
+int ImagePyramid::levelFor(double pixelsPerPixel) const
+{
+    int index = 0;
+    while (index + 1 < levels() && (double)pyramid[index + 1].cols / pyramid[0].cols >= pixelsPerPixel)
+    {
+        index++;
+    }
+    return index;
+}
+
+Mat ImagePyramid::proxy(int maxSide) const
+{
+    if (empty())
+        return Mat();
+
+    int longestSide = max(pyramid[0].cols, pyramid[0].rows);
+    if (longestSide <= maxSide)
+        return pyramid[0];
+
+    // the size resize(image, Size(), scale, scale) gives, from a level at most twice as large
+    double scale = (double)maxSide / longestSide;
+    Size proxySize(saturate_cast<int>(pyramid[0].cols * scale), saturate_cast<int>(pyramid[0].rows * scale));
+    Mat proxy;
+    resize(pyramid[levelFor(scale)], proxy, proxySize, 0, 0, INTER_AREA);
+    return proxy;
+}
+
+Mat ImagePyramid::view(Rect2d region, Size size) const
+{
+    Mat view;
+    this->view(region, size, view);
+    return view;
+}
+
+void ImagePyramid::view(Rect2d region, Size size, Mat &dst) const
+{
+    if (empty() || region.width <= 0 || region.height <= 0 || size.empty())
+    {
+        dst.release();
+        return;
+    }
+
+    const Mat &source = pyramid[levelFor(max(size.width / region.width, size.height / region.height))];
+    double scaleX = (double)source.cols / pyramid[0].cols;
+    double scaleY = (double)source.rows / pyramid[0].rows;
+
+    // centre of output pixel u is at region.x + (u + 0.5) * stepX in level 0, pixel centres of the
+    // level are at integers
+    double stepX = region.width * scaleX / size.width;
+    double stepY = region.height * scaleY / size.height;
+    Matx23d toSource(stepX, 0, region.x * scaleX + 0.5 * stepX - 0.5,
+                     0, stepY, region.y * scaleY + 0.5 * stepY - 0.5);
+
+    warpAffine(source, dst, toSource, size, INTER_LINEAR | WARP_INVERSE_MAP, BORDER_CONSTANT);
+}
@@ -0,0 +1,40 @@
+#ifndef IMAGE_PYRAMID_H
+#define IMAGE_PYRAMID_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Mipmaps of one image: level 0 shares the pixels of the image and every further level is the
+// previous one halved with area averaging, down to a few pixels. Interactive tools draw their
+// previews from the level closest to the display size, so the cost of a preview follows the size
+// of the window and not the size of the image.
+class ImagePyramid
+{
+public:
+    ImagePyramid() = default;
+    explicit ImagePyramid(const cv::Mat &image, int minimumSide = 16);
+
+    bool empty() const;
+    int levels() const;
+    const cv::Mat &level(int index) const;
+    // Size of level 0
+    cv::Size size() const;
+
+    // The image scaled to at most maxSide pixels a side, the image itself when it already fits.
+    // Same size as previewProxy(image, maxSide).
+    cv::Mat proxy(int maxSide) const;
+    // region, in pixels of level 0, resampled to size from the coarsest level that still has the
+    // resolution of size. Parts of region outside the image are black.
+    cv::Mat view(cv::Rect2d region, cv::Size size) const;
+    // Same, drawn into dst. Its pixels are reused when it already has size and the type of the
+    // image, so dst can wrap a display buffer.
+    void view(cv::Rect2d region, cv::Size size, cv::Mat &dst) const;
+
+private:
+    // coarsest level with at least pixelsPerPixel pixels for every pixel of level 0
+    int levelFor(double pixelsPerPixel) const;
+
+    std::vector<cv::Mat> pyramid;
+};
+
+#endif // IMAGE_PYRAMID_H
@@ -1,14 +1,28 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "canny_edges.h"
+#include "frequency_domain.h"
+#include "image_analytics.h"
+#include "image_history.h"
+#include "image_processing.h"
+#include "image_pyramid.h"
+#include "point_lut.h"
+#include "recipe.h"
+#include "scale_space.h"
 #include <QPushButton>
 #include <QToolButton>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QCheckBox>
+#include <QComboBox>
 #include <QDoubleValidator>
 #include <QIntValidator>
+#include <QPainter>
+#include <QSignalBlocker>
 #include <opencv2/opencv.hpp>
+#include <cstdio>
 #include <iostream>
+#include <list>
 #include <string>
 // #include "clickable_label.h"
 
@@ -18,18 +32,94 @@ using namespace std;
 bool didEditFinish = false, shouldRotate;
 int prevX, prevY, d0 = 50;
 float angle, scale = 1;
-Mat image, imageGrayed, ROI, dstTranslatedImage, dstRotatedImage, dstZoomedImage, dstAreaOfInterestImage, dstDeSkewedImage, dstSmoothedImage, dstFrequencyDomainImage;
+// transform of the current geometry edit in pixels of the image, and what it was before the
+// rotation being dragged
+Mat affineMatrix, rotationBase;
+Mat image, imageGrayed, ROI, dstTranslatedImage, dstRotatedImage, dstAreaOfInterestImage, dstDeSkewedImage, dstSmoothedImage, dstFrequencyDomainImage;
 vector<Point> vertices;
-vector<Mat> images;
+ImageHistory images;
 vector<Point2f> srcPoints, dstPoints;
 int currentImageIndex = 0;
 QString fileName;
 
-struct NumberFrequency
+// Tone chain mode: consecutive point operations are composed into toneChainLut and applied to the
+// gray plane the chain started from, toneChainHistogram follows the histogram of the result
+const string toneCurveWindowName = "Tone Curve";
+Mat toneChainBase, toneChainLut;
+vector<long long> toneChainHistogram;
+// revision produced by the last step of the chain, -1 when the next step starts a new chain
+int toneChainIndex = -1;
+
+// The median, frequency domain, Canny and Laplacian tools tune their parameters on a proxy of at
+// most previewSide pixels a side, the full resolution operation only runs on submit
+const int previewSide = 1024;
+
+// in pixels of the full resolution image
+int medianRadius = 1;
+
+// Translate, rotate and deskew draw on previewImage, taken from the pyramid of the revision.
+// previewScale is the number of preview pixels per pixel of the image being edited, the mouse
+// positions are divided by it and the full resolution image is only transformed on submit.
+shared_ptr<const ImagePyramid> previewPyramid;
+Mat previewImage;
+double previewScale = 1;
+
+// Zoom and pan of currentImageContainer, only what is shown changes. viewZoom is relative to the
+// whole revision fitting the label and viewCentre is in pixels of the revision.
+double viewZoom = 1;
+Point2d viewCentre;
+const double maximumViewZoom = 64;
+
+// Pixmaps currentImageContainer showed recently, the most recent first. An entry holds for the region
+// and the label size it was drawn with, so undo, redo and show diff only look pixmaps up while the
+// view doesn't move. A missing one is warped from the pyramid straight into displayBuffer, in a
+// format Qt reads without converting.
+struct DisplayEntry
 {
-    int frequency;
-    double probability;
+    unsigned long long revision;
+    // part of the revision shown, in its pixels
+    Rect2d region;
+    Size size;
+    QPixmap pixmap;
 };
+list<DisplayEntry> displayCache;
+const size_t displayCacheEntries = 8;
+QImage displayBuffer;
+
+// Items of compareModeBox, how the revisions after the original are shown
+enum class CompareMode
+{
+    Off,
+    // the original left of the middle of the label, the revision right of it
+    Split,
+    // the original blended half way over the revision
+    OnionSkin
+};
+
+// Format of a QImage sharing the layout of an 8 bit Mat of the given type
+static QImage::Format displayFormat(int type)
+{
+    switch (type)
+    {
+    case CV_8UC1:
+        return QImage::Format_Grayscale8;
+    case CV_8UC3:
+        return QImage::Format_BGR888;
+    case CV_8UC4:
+        // 0xAARRGGBB words, B G R A bytes in memory on little endian machines
+        return QImage::Format_ARGB32;
+    default:
+        return QImage::Format_Invalid;
+    }
+}
+
+const string frequencySpectrumWindowName = "Spectrum";
+int frequencyShape = (int)FrequencyFilterShape::Ideal, frequencyOrder = 2, frequencyWidth = 20;
+
+int cannyLow = 50, cannyHigh = 150;
+
+// sigma of the finest scale in pixels of the full resolution image, every further scale doubles it
+int laplacianSigma = 2, laplacianScales = 1, laplacianContrast = 8;
 
 struct TrackbarWindowData
 {
@@ -37,6 +127,10 @@ struct TrackbarWindowData
     cv::Mat dstImage;
     string windowName;
     MainWindow *mainWindow;
+    // parameters that produced dstImage, recorded in the history on submit
+    ImageOperation operation;
+    // gray levels of image, the normalization of point operations is derived from it
+    vector<long long> histogram;
 };
 
 struct ZoomData
@@ -44,6 +138,11 @@ struct ZoomData
     int rectangleSize;
     // optional kernel make it optional to use a kernel
     cv::Mat kernel;
+    // every click is appended so the edit can be replayed
+    ImageOperation operation;
+    // rectangle drawn under the cursor, and scratch pixels reused between clicks
+    cv::Rect cursor;
+    cv::Mat buffer;
 };
 
 enum KeyCodes
@@ -58,6 +157,28 @@ QMap<Categories, std::vector<QToolButton *>> categorySubItems;
 
 QMap<Categories, QPushButton *> categoryBtns;
 
+// Revisions image and imageGrayed hold, 0 for none. Undo and redo only move currentImageIndex and
+// show the cached pixmap, the pixels are read back from the history once a tool needs them.
+unsigned long long imageRevision = 0, grayRevision = 0;
+
+// Makes image the working copy of revision currentImageIndex and imageGrayed its gray plane, every
+// tool calls it before reading either. The gray plane is derived once per revision and may share
+// the pixels of the history, so imageGrayed is only ever reassigned, never written into.
+void loadCurrentImage()
+{
+    unsigned long long revision = images.revisionId(currentImageIndex);
+    if (imageRevision != revision)
+    {
+        images.at(currentImageIndex).copyTo(image);
+        imageRevision = revision;
+    }
+    if (grayRevision != revision)
+    {
+        imageGrayed = images.grayPlane(currentImageIndex);
+        grayRevision = revision;
+    }
+}
+
 void resetEdit()
 {
     destroyAllWindows();
@@ -67,17 +188,117 @@ void resetEdit()
     prevY = 0;
     angle = 0;
     scale = 1;
+    affineMatrix = Mat::eye(2, 3, CV_64F);
+    rotationBase = Mat::eye(2, 3, CV_64F);
     dstPoints.clear();
     srcPoints.clear();
     vertices.clear();
 }
 
+// Proxy of the current revision for the translate, rotate and deskew tools
+void startPreview()
+{
+    previewPyramid = images.pyramid(currentImageIndex);
+    previewImage = previewPyramid->proxy(previewSide);
+    previewScale = (double)previewImage.cols / image.cols;
+}
+
+// Part of a revision of imageSize shown on displaySize pixels, displayScale is the number of
+// display pixels per pixel of the revision. An axis the revision doesn't fill is centred, otherwise
+// the region stays on the revision.
+static Rect2d visibleRegion(Size imageSize, Size displaySize, double &displayScale)
+{
+    displayScale = min((double)displaySize.width / imageSize.width, (double)displaySize.height / imageSize.height) * viewZoom;
+    Size2d extent(displaySize.width / displayScale, displaySize.height / displayScale);
+
+    auto clampCentre = [](double centre, double extent, double side)
+    {
+        return extent >= side ? side / 2 : min(max(centre, extent / 2), side - extent / 2);
+    };
+    Point2d centre(clampCentre(viewCentre.x, extent.width, imageSize.width), clampCentre(viewCentre.y, extent.height, imageSize.height));
+    return Rect2d(centre.x - extent.width / 2, centre.y - extent.height / 2, extent.width, extent.height);
+}
+
+static void resetView(Size imageSize)
+{
+    viewZoom = 1;
+    viewCentre = Point2d(imageSize.width / 2.0, imageSize.height / 2.0);
+}
+
+// Size of the label in pixels of the screen
+static Size displaySizeOf(QLabel *label)
+{
+    qreal pixelRatio = label->devicePixelRatioF();
+    return Size(cvRound(label->contentsRect().width() * pixelRatio), cvRound(label->contentsRect().height() * pixelRatio));
+}
+
+// Part of the original showing what region of revision index shows, through the crops and zooms
+// recorded since. False when they don't account for the size of the revision, e.g. an edit that
+// changed the size without recording its operation or an evicted crop.
+static bool originalRegion(int index, Rect2d region, Rect2d &original)
+{
+    vector<ImageOperation> log = images.operationLog(index);
+
+    // the edits that keep the size keep the frame, a crop moves it and a zoom also halves its scale
+    Size size = images.imageSize(0);
+    vector<Point> cropOffsets;
+    for (const ImageOperation &operation : log)
+    {
+        if (operation.type == OperationType::Crop)
+        {
+            Rect crop = operation.regions.at(0) & Rect(Point(), size);
+            cropOffsets.push_back(crop.tl());
+            size = crop.size();
+        }
+        else if (operation.type == OperationType::Zoom)
+        {
+            for (const Rect &zoom : operation.regions)
+            {
+                size = zoom.size() * 2;
+            }
+        }
+    }
+    if (size != images.imageSize(index))
+        return false;
+
+    for (auto operation = log.rbegin(); operation != log.rend(); operation++)
+    {
+        if (operation->type == OperationType::Crop)
+        {
+            Point offset = cropOffsets.back();
+            cropOffsets.pop_back();
+            region.x += offset.x;
+            region.y += offset.y;
+        }
+        else if (operation->type == OperationType::Zoom)
+        {
+            for (auto zoom = operation->regions.rbegin(); zoom != operation->regions.rend(); zoom++)
+            {
+                region = Rect2d(zoom->x + region.x / 2, zoom->y + region.y / 2, region.width / 2, region.height / 2);
+            }
+        }
+    }
+
+    original = region;
+    return true;
+}
+
+// Affine matrix of the image being edited applied to previewImage instead
+static Mat previewMatrix(const Mat &matrix)
+{
+    Mat scaled = matrix.clone();
+    scaled.at<double>(0, 2) *= previewScale;
+    scaled.at<double>(1, 2) *= previewScale;
+    return scaled;
+}
+
 // Translate
 void translateWindowMouseHandler(int event, int x, int y, int flags, void *userdata)
 {
     if (event == EVENT_RBUTTONDOWN)
     {
-        dstTranslatedImage.copyTo(image);
+        // the drag was previewed on the proxy, the image is warped once here
+        image = affineTransform(image, affineMatrix);
         didEditFinish = true;
         return;
     }
@@ -101,8 +322,11 @@ void translateWindowMouseHandler(int event, int x, int y, int flags, void *userd
         int tyValue = y - prevY;
         prevX = x;
         prevY = y;
-        Mat translationMatrix = (Mat_<float>(2, 3) << 1, 0, txValue, 0, 1, tyValue);
-        warpAffine(dstTranslatedImage, dstTranslatedImage, translationMatrix, image.size());
+
+        // accumulate the translation and warp the source once, nothing is clipped while dragging
+        affineMatrix.at<double>(0, 2) += txValue / previewScale;
+        affineMatrix.at<double>(1, 2) += tyValue / previewScale;
+        dstTranslatedImage = affineTransform(previewImage, previewMatrix(affineMatrix));
         return;
     }
 }
@@ -112,7 +336,7 @@ void rotationWindowMouseHandler(int event, int x, int y, int flags, void *userda
 {
     if (event == EVENT_RBUTTONDOWN)
     {
-        dstRotatedImage.copyTo(image);
+        image = affineTransform(image, affineMatrix);
         didEditFinish = true;
         return;
     }
@@ -121,6 +345,8 @@ void rotationWindowMouseHandler(int event, int x, int y, int flags, void *userda
         prevX = x;
         prevY = y;
         shouldRotate = true;
+        // every drag rotates on top of the previous ones
+        rotationBase = affineMatrix.clone();
         return;
     }
 
@@ -132,82 +358,63 @@ void rotationWindowMouseHandler(int event, int x, int y, int flags, void *userda
 
     if (event == EVENT_MOUSEMOVE && shouldRotate)
     {
-        int sensitivity = image.cols;
+        int sensitivity = previewImage.cols;
         int xDiff = x - prevX;
         angle = (xDiff * 1.0 / sensitivity * 1.0) * 360;
-        Mat rotationMatrix = getRotationMatrix2D(Point2f(prevX, prevY), angle, scale);
-        warpAffine(image, dstRotatedImage, rotationMatrix, image.size());
+        affineMatrix = composeAffine(rotationBase, getRotationMatrix2D(Point2f(prevX / previewScale, prevY / previewScale), angle, 1));
+        dstRotatedImage = affineTransform(previewImage, previewMatrix(affineMatrix));
         return;
     }
 
     if (event == EVENT_MOUSEWHEEL)
     {
-        float step = 0.01;
-        scale += (y < 0 ? -1.0 * step : step);
-        if (scale < 0.1)
-            scale = 0.1;
-        Mat rotationMatrix = getRotationMatrix2D(Point2f(prevX, prevY), angle, scale);
-        warpAffine(image, dstRotatedImage, rotationMatrix, image.size());
+        float factor = y < 0 ? 0.99 : 1.01;
+        if (scale * factor < 0.1)
+            return;
+        scale *= factor;
+
+        // scaling about the rotation centre commutes with the rotation
+        Mat scaling = getRotationMatrix2D(Point2f(prevX / previewScale, prevY / previewScale), 0, factor);
+        affineMatrix = composeAffine(affineMatrix, scaling);
+        rotationBase = composeAffine(rotationBase, scaling);
+        dstRotatedImage = affineTransform(previewImage, previewMatrix(affineMatrix));
         return;
     }
 }
 
-// Zoom
-void zoomWindowMouseHandler(int event, int x, int y, int flags, void *zoomData)
+// h and v in the translate and rotate windows mirror the image within the same transform, instead
+// of a separate flip after it is resampled
+static bool composeFlipKey(int keyCode)
 {
-    ZoomData *data = (ZoomData *)zoomData;
-    int &rectangleSize = data->rectangleSize;
-
-    if (event == EVENT_MOUSEMOVE)
-    {
-        //  erase the previous rectangle
-        prevX = x;
-        prevY = y;
-        image.copyTo(dstZoomedImage);
-        rectangle(dstZoomedImage, Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize), Scalar(0, 0, 0), 2);
-    }
-
-    if (event == EVENT_MOUSEWHEEL)
-    {
-        if (y == 0)
-            return;
-        rectangleSize += (y > 0 ? 10 : -10);
-        if (rectangleSize < 10)
-        {
-            rectangleSize = 10;
-        }
-
-        image.copyTo(dstZoomedImage);
-        rectangle(dstZoomedImage, Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize), Scalar(0, 0, 0), 2);
-    }
-
-    if (event == EVENT_LBUTTONDOWN)
-    {
-        int xStart = prevX - rectangleSize;
-        int yStart = prevY - rectangleSize;
-        int xEnd = prevX + rectangleSize;
-        int yEnd = prevY + rectangleSize;
-        rectangleSize -= 1;
-
-        if (xStart < 0 || yStart < 0 || xEnd > image.cols || yEnd > image.rows)
-        {
-            QMessageBox::warning(nullptr, "Error", "Please select a valid area to zoom");
-            return;
-        }
+    if (keyCode != 'h' && keyCode != 'v')
+        return false;
+
+    // same names as the flip popup and flip(horizontal|vertical): h turns the image upside down
+    // (flip code 0), v mirrors each row (flip code 1)
+    Mat flip = flipMatrix(keyCode == 'h' ? 0 : 1, image.size());
+    affineMatrix = composeAffine(affineMatrix, flip);
+    rotationBase = composeAffine(rotationBase, flip);
+    return true;
+}
 
-        Mat croppedImage = image(Rect(prevX - rectangleSize, prevY - rectangleSize, rectangleSize * 2, rectangleSize * 2));
-        cv::resize(croppedImage, image, Size(), 2, 2);
-        image.copyTo(dstZoomedImage);
-    }
+// Brush cursor of the area of interest and smoothing tools. Only the pixels under the previous
+// rectangle are restored from source, moving the cursor costs O(rectangle) instead of O(image).
+static void moveCursorRectangle(const Mat &source, Mat &display, Rect &cursor, int rectangleSize)
+{
+    Rect bounds(0, 0, source.cols, source.rows);
+    Rect previous = (cursor + Size(2, 2) - Point(1, 1)) & bounds;
+    source(previous).copyTo(display(previous));
 
-    if (event == EVENT_RBUTTONDOWN)
-    {
-        image.copyTo(dstZoomedImage);
-        didEditFinish = true;
-    }
+    cursor = Rect(Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize));
+    rectangle(display, cursor.tl(), cursor.br(), Scalar(0, 0, 0), 2);
 }
 
 // Gray Level Slicing
+// Gray plane the area of interest tool started from, the slicing of every click composed into one
+// table, and the region histograms of the sliced result
+Mat areaOfInterestBase, areaOfInterestLut;
+IntegralHistogram areaOfInterestHistogram;
+
 void areaOfInterestMouseHandler(int event, int x, int y, int flags, void *areaOfInterestData)
 {
     ZoomData *data = (ZoomData *)areaOfInterestData;
@@ -218,8 +425,7 @@ void areaOfInterestMouseHandler(int event, int x, int y, int flags, void *areaOf
         //  erase the previous rectangle
         prevX = x;
         prevY = y;
-        imageGrayed.copyTo(dstAreaOfInterestImage);
-        rectangle(dstAreaOfInterestImage, Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize), Scalar(0, 0, 0), 2);
+        moveCursorRectangle(imageGrayed, dstAreaOfInterestImage, data->cursor, rectangleSize);
     }
 
     if (event == EVENT_MOUSEWHEEL)
@@ -232,8 +438,7 @@ void areaOfInterestMouseHandler(int event, int x, int y, int flags, void *areaOf
             rectangleSize = 10;
         }
 
-        imageGrayed.copyTo(dstAreaOfInterestImage);
-        rectangle(dstAreaOfInterestImage, Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize), Scalar(0, 0, 0), 2);
+        moveCursorRectangle(imageGrayed, dstAreaOfInterestImage, data->cursor, rectangleSize);
     }
 
     if (event == EVENT_LBUTTONDOWN)
@@ -242,66 +447,21 @@ void areaOfInterestMouseHandler(int event, int x, int y, int flags, void *areaOf
         int yStart = prevY - rectangleSize;
         int xEnd = prevX + rectangleSize;
         int yEnd = prevY + rectangleSize;
-        int rangeFrom = 255;
-        int rangeTo = 0;
-        std::map<int, NumberFrequency> rangeValues = {};
 
-        int totalSelectedPixels = pow(rectangleSize * 2, 2);
+        // O(256) for the whole blocks under the rectangle, whatever its size
+        vector<long long> histogram = areaOfInterestHistogram.histogram(Rect(xStart, yStart, xEnd - xStart, yEnd - yStart));
+        auto [rangeFrom, rangeTo] = grayLevelRange(histogram);
 
-        // get the range from the rectangle selected
-        for (int i = yStart; i < yEnd; i++)
-        {
-            for (int j = xStart; j < xEnd; j++)
-            {
-                if (rangeValues.find(imageGrayed.at<uchar>(i, j)) == rangeValues.end())
-                {
-                    rangeValues.insert({imageGrayed.at<uchar>(i, j), {1, 1.0 / (totalSelectedPixels * 1.0)}});
-                    // rangeValues[imageGrayed.at<uchar>(i, j)] = {frequency : 1, probability : 1 / totalSelectedPixels};
-                }
-                else
-                {
-                    rangeValues.at(imageGrayed.at<uchar>(i, j)).frequency += 1;
-                    rangeValues.at(imageGrayed.at<uchar>(i, j)).probability = rangeValues.at(imageGrayed.at<uchar>(i, j)).frequency / (totalSelectedPixels * 1.0);
-                }
-            }
-        }
-
-        for (auto const &[key, value] : rangeValues)
-        {
-            if (value.probability > 0.005)
-            {
-                if (key < rangeFrom)
-                {
-                    rangeFrom = key;
-                }
-
-                if (key > rangeTo)
-                {
-                    rangeTo = key;
-                }
-            }
-        }
+        // every click slices the result of the previous one, the base is mapped once through all of them
+        Mat sliceLut = grayLevelSlicingLut(rangeFrom, rangeTo, data->operation.option == 1);
+        areaOfInterestLut = composeLuts(areaOfInterestLut, sliceLut);
+        areaOfInterestHistogram.remap(sliceLut);
+        imageGrayed = applyLut(areaOfInterestBase, areaOfInterestLut);
 
-        cout << "xStart: " << xStart << " yStart: " << yStart << " xEnd: " << xEnd << " yEnd: " << yEnd << endl;
-        cout << "Range from: " << rangeFrom << " Range to: " << rangeTo << endl;
-
-        // get the value to be set if r(i,j) not in range [A,B] if this value is not provided r(i,j) = r(i,j) it will not replace the value out of range.
-        for (int i = 0; i < imageGrayed.rows; i++)
-        {
-            for (int j = 0; j < imageGrayed.cols; j++)
-            {
-                int pointValue = imageGrayed.at<uchar>(i, j);
-                if (pointValue > rangeFrom && pointValue < rangeTo)
-                {
-                    imageGrayed.at<uchar>(i, j) = 255;
-                }
-                else
-                {
-                    imageGrayed.at<uchar>(i, j) = 0;
-                }
-            }
-        }
+        data->operation.values.push_back(rangeFrom);
+        data->operation.values.push_back(rangeTo);
         imageGrayed.copyTo(dstAreaOfInterestImage);
+        data->cursor = Rect();
     }
 
     if (event == EVENT_RBUTTONDOWN)
@@ -318,21 +478,19 @@ void deSkewImageMouseHandler(int event, int x, int y, int, void *userdata)
     {
         if (srcPoints.size() < 3)
         {
-            srcPoints.push_back(Point2f(x, y));
+            srcPoints.push_back(Point2f(x / previewScale, y / previewScale));
             circle(dstDeSkewedImage, Point(x, y), 5, Scalar(0, 0, 255), 2);
-            cout << "Selected source point: (" << x << ", " << y << ")" << endl;
         }
         else if (dstPoints.size() < 3)
         {
-            dstPoints.push_back(Point2f(x, y));
+            dstPoints.push_back(Point2f(x / previewScale, y / previewScale));
             circle(dstDeSkewedImage, Point(x, y), 5, Scalar(0, 255, 0), 2);
-            cout << "Selected destination point: (" << x << ", " << y << ")" << endl;
         }
 
         if (srcPoints.size() == 3 && dstPoints.size() == 3)
         {
-            Mat skewingMatrix = getAffineTransform(srcPoints, dstPoints);
-            warpAffine(image, dstDeSkewedImage, skewingMatrix, image.size());
+            affineMatrix = getAffineTransform(srcPoints, dstPoints);
+            dstDeSkewedImage = affineTransform(previewImage, previewMatrix(affineMatrix));
         }
     }
 
@@ -355,8 +513,7 @@ void smoothingFiltersMouseHandler(int event, int x, int y, int, void *smoothImag
         //  erase the previous rectangle
         prevX = x;
         prevY = y;
-        image.copyTo(dstSmoothedImage);
-        rectangle(dstSmoothedImage, Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize), Scalar(0, 0, 0), 2);
+        moveCursorRectangle(image, dstSmoothedImage, data->cursor, rectangleSize);
     }
 
     if (event == EVENT_MOUSEWHEEL)
@@ -369,53 +526,21 @@ void smoothingFiltersMouseHandler(int event, int x, int y, int, void *smoothImag
             rectangleSize = 10;
         }
 
-        image.copyTo(dstSmoothedImage);
-        rectangle(dstSmoothedImage, Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize), Scalar(0, 0, 0), 2);
+        moveCursorRectangle(image, dstSmoothedImage, data->cursor, rectangleSize);
     }
 
     if (event == EVENT_LBUTTONDOWN)
     {
-        if (image.channels() != 1)
-            cvtColor(image, imageGrayed, COLOR_BGR2GRAY);
-        else
-            image.copyTo(imageGrayed);
-        Mat tempImage = imageGrayed.clone();
-        imageGrayed.copyTo(dstSmoothedImage);
-        filter2D(imageGrayed, tempImage, CV_8UC1, kernel);
-        int initialI = prevY - rectangleSize;
-        int initialJ = prevX - rectangleSize;
-        int finalI = prevY + rectangleSize;
-        int finalJ = prevX + rectangleSize;
-
-        // check if the selected area is out of bounds
-        if (initialI < 0)
-        {
-            initialI = 0;
-        }
-
-        if (initialJ < 0)
-        {
-            initialJ = 0;
-        }
-        if (finalI > image.rows)
-        {
-            finalI = image.rows;
-        }
-        if (finalJ > image.cols)
-        {
-            finalJ = image.cols;
-        }
-
-        // apply the filter only in the selected area
-        for (int i = initialI; i < finalI; i++)
-        {
-            for (int j = initialJ; j < finalJ; j++)
-            {
-                dstSmoothedImage.at<uchar>(i, j) = tempImage.at<uchar>(i, j);
-            }
-        }
+        Rect region(Point(prevX - rectangleSize, prevY - rectangleSize), Point(prevX + rectangleSize, prevY + rectangleSize));
+        region &= Rect(0, 0, image.cols, image.rows);
+        if (region.empty())
+            return;
 
-        dstSmoothedImage.copyTo(image);
+        // only the brush and its kernel halo are read, image is the working copy of this edit
+        smoothRegionInPlace(image, kernel, region, data->buffer);
+        data->operation.regions.push_back(region);
+        // restores the smoothed pixels under the cursor and draws it again
+        moveCursorRectangle(image, dstSmoothedImage, data->cursor, rectangleSize);
     }
 
     if (event == EVENT_RBUTTONDOWN)
@@ -430,8 +555,7 @@ void brightnessAdjustmentMouseHandler(int event, int x, int y, int, void *data)
     if (event == EVENT_RBUTTONDOWN)
     {
         TrackbarWindowData *userData = (TrackbarWindowData *)data;
-        userData->dstImage.copyTo(image);
-        userData->mainWindow->onImageProcessingSubmit(true);
+        userData->mainWindow->submitPointOperation(userData->operation);
         destroyWindow(userData->windowName);
     }
 }
@@ -444,79 +568,41 @@ void frequencyDomainMouseHandler(int event, int x, int y, int, void *data)
 
         didEditFinish = true;
         destroyWindow(userData->windowName);
-        userData->dstImage.copyTo(image);
-        userData->mainWindow->onImageProcessingSubmit(true);
+        destroyWindow(frequencySpectrumWindowName);
+        // the preview ran on the proxy, the full resolution transform runs once here
+        applyOperation(imageGrayed, userData->operation).copyTo(image);
+        userData->mainWindow->onImageProcessingSubmit(true, userData->operation);
     }
 }
 
-void segmentationThresholdingMouseHandler(int event, int x, int y, int, void *data)
+void proxyPreviewMouseHandler(int event, int x, int y, int, void *data)
 {
-    cout << "EVENT: " << event << endl;
     if (event == EVENT_RBUTTONDOWN)
     {
-        didEditFinish = true;
         TrackbarWindowData *userData = (TrackbarWindowData *)data;
-        cout << "Destroying window: " << userData->windowName << endl;
+
+        didEditFinish = true;
         destroyWindow(userData->windowName);
-        cout << "Copying image to main image" << endl;
-        userData->dstImage.copyTo(image);
-        cout << "Calling onImageProcessingSubmit" << endl;
-        userData->mainWindow->onImageProcessingSubmit(true);
-        cout << "Finished" << endl;
+        // the parameters were tuned on the proxy, the full resolution operation runs once here
+        applyOperation(userData->image, userData->operation).copyTo(image);
+        userData->mainWindow->onImageProcessingSubmit(true, userData->operation);
     }
 }
 
-int imageDepth2Bits(int depth)
+void segmentationThresholdingMouseHandler(int event, int x, int y, int, void *data)
 {
-    switch (depth)
+    if (event == EVENT_RBUTTONDOWN)
     {
-    case CV_8U:
-    case CV_8S:
-        return 8;
-    case CV_16U:
-    case CV_16S:
-        return 16;
-    case CV_32S:
-    case CV_32F:
-        return 32;
-    case CV_64F:
-        return 64;
-    default:
-        return 0;
+        didEditFinish = true;
+        TrackbarWindowData *userData = (TrackbarWindowData *)data;
+        destroyWindow(userData->windowName);
+        userData->mainWindow->submitPointOperation(userData->operation);
     }
 }
 
-tuple<int, int, int, int> imageDetails(Mat img)
+tuple<size_t, int, int, int> imageDetails(Mat img)
 {
-    return make_tuple((int)img.total(), (int)img.rows, (int)img.cols, (int)img.depth());
-}
-
-tuple<int, int, int> imageMinMaxAvg(Mat img)
-{
-    int max = 0;
-    int min = 255;
-    int pixelsValues = 0;
-
-    for (int i = 0; i < img.rows; i++)
-    {
-        for (int j = 0; j < img.cols; j++)
-        {
-            int pointValue = img.at<uchar>(i, j);
-            pixelsValues += pointValue;
-
-            if (pointValue > max)
-            {
-                max = pointValue;
-            }
-
-            if (pointValue < min)
-            {
-                min = pointValue;
-            }
-        }
-    }
-
-    return make_tuple(min, max, pixelsValues / img.total());
+    return make_tuple(img.total(), img.rows, img.cols, img.depth());
 }
 
 // Without changing the format
@@ -531,12 +617,10 @@ QImage matToQImage(Mat img)
                       QImage::Format_Grayscale8)
             .copy();
     }
-    else if (img.type() == CV_8UC3) // RGB
+    else if (img.type() == CV_8UC3) // BGR, Qt reads the channel order as is
     {
-        Mat rgbImg;
-        cvtColor(img, rgbImg, COLOR_BGR2RGB);
-        return QImage(rgbImg.data, rgbImg.cols, rgbImg.rows, rgbImg.step,
-                      QImage::Format_RGB888)
+        return QImage(img.data, img.cols, img.rows, img.step,
+                      QImage::Format_BGR888)
             .copy();
     }
     else if (img.type() == CV_8UC4) // RGBA
@@ -565,9 +649,10 @@ void showImage(string windowName, Mat image)
     destroyWindow(windowName);
 }
 
-int imgSize(Mat img)
+// Bits of the raw pixels, every channel at the bit depth of the image
+size_t imgSize(Mat img)
 {
-    return img.total() * imageDepth2Bits(img.depth());
+    return img.total() * img.channels() * imageDepth2Bits(img.depth());
 }
 
 int MainWindow::showFlipPopup()
@@ -661,6 +746,8 @@ void MainWindow::setupBtnFunctionalities()
 
     connect(ui->cvtToGrayBtn, &QPushButton::clicked, this, &MainWindow::onCvtGrayBtnClicked);
     connect(ui->currentImageContainer, SIGNAL(clicked()), this, SLOT(onImageContainerClicked()));
+    connect(ui->currentImageContainer, SIGNAL(wheelScrolled(QPoint, double)), this, SLOT(onImageContainerScrolled(QPoint, double)));
+    connect(ui->currentImageContainer, SIGNAL(dragged(QPoint)), this, SLOT(onImageContainerDragged(QPoint)));
     connect(ui->translateBtn, &QPushButton::clicked, this, &MainWindow::onTranslateBtnClicked);
     connect(ui->rotateBtn, &QPushButton::clicked, this, &MainWindow::onRotateBtnClicked);
     connect(ui->flipBtn, &QPushButton::clicked, this, &MainWindow::onFlipBtnClicked);
@@ -669,7 +756,7 @@ void MainWindow::setupBtnFunctionalities()
     connect(ui->negativeBtn, &QPushButton::clicked, this, &MainWindow::onNegativeBtnClicked);
     connect(ui->logTransformBtn, &QPushButton::clicked, this, &MainWindow::onLogTransformationBtnClicked);
     connect(ui->bitSlicingBtn, &QPushButton::clicked, this, &MainWindow::onBitSlicingBtnClicked);
-    connect(ui->zoomBtn, &QPushButton::clicked, this, &MainWindow::onZoomBtnClicked);
+    connect(ui->zoomBtn, &QPushButton::clicked, this, &MainWindow::onCropToViewBtnClicked);
     connect(ui->areaOfInterestBtn, &QPushButton::clicked, this, &MainWindow::onAreaOfInterestBtnClicked);
     connect(ui->deSkewImageBtn, &QPushButton::clicked, this, &MainWindow::onDeSkewBtnClicked);
     connect(ui->smoothingBtn, &QPushButton::clicked, this, &MainWindow::onSmoothingBtnClicked);
@@ -678,12 +765,16 @@ void MainWindow::setupBtnFunctionalities()
     connect(ui->frequencyDomainBtn, &QPushButton::clicked, this, &MainWindow::onFrequencyDomainBtnClicked);
     connect(ui->segmentationBtn, &QPushButton::clicked, this, &MainWindow::onSegmentationBtnClicked);
     connect(ui->laplacianOfGaussianBtn, &QPushButton::clicked, this, &MainWindow::onLaplacianOfGaussianBtnClicked);
+    connect(ui->cannyBtn, &QPushButton::clicked, this, &MainWindow::onCannyBtnClicked);
+    connect(ui->toneChainBtn, &QToolButton::toggled, this, &MainWindow::onToneChainBtnToggled);
 
     connect(ui->undoBtn, &QPushButton::clicked, this, &MainWindow::onUndoBtnClicked);
     connect(ui->resetBtn, &QPushButton::clicked, this, &MainWindow::onResetBtnClicked);
     connect(ui->showDiffBtn, &QPushButton::pressed, this, &MainWindow::onShowDiffBtnPressed);
     connect(ui->showDiffBtn, &QPushButton::released, this, &MainWindow::onShowDiffBtnReleased);
     connect(ui->redoBtn, &QPushButton::clicked, this, &MainWindow::onRedoBtnClicked);
+    connect(ui->compareModeBox, &QComboBox::currentIndexChanged, this, [this]()
+            { showRevision(currentImageIndex); });
 
     connect(ui->clarityBtn, &QPushButton::clicked, this, [this]()
             { changeToolCategory(Clarity); });
@@ -704,8 +795,8 @@ void MainWindow::setupBtnFunctionalities()
 
     categorySubItems[Clarity] = std::vector<QToolButton *>{ui->medianBtn, ui->smoothingBtn, ui->frequencyDomainBtn};
     categorySubItems[Adjust] = std::vector<QToolButton *>{ui->translateBtn, ui->rotateBtn, ui->flipBtn, ui->zoomBtn, ui->deSkewImageBtn};
-    categorySubItems[Effect] = std::vector<QToolButton *>{ui->histogramEqBtn, ui->negativeBtn, ui->logTransformBtn, ui->cvtToGrayBtn, ui->areaOfInterestBtn};
-    categorySubItems[Detection] = std::vector<QToolButton *>{ui->sobelBtn, ui->segmentationBtn, ui->laplacianOfGaussianBtn};
+    categorySubItems[Effect] = std::vector<QToolButton *>{ui->histogramEqBtn, ui->negativeBtn, ui->logTransformBtn, ui->cvtToGrayBtn, ui->areaOfInterestBtn, ui->toneChainBtn};
+    categorySubItems[Detection] = std::vector<QToolButton *>{ui->sobelBtn, ui->segmentationBtn, ui->laplacianOfGaussianBtn, ui->cannyBtn};
     categorySubItems[UnCategorized] = std::vector<QToolButton *>{ui->brightnessAdjustBtn, ui->bitSlicingBtn};
 
     changeToolCategory(Categories::Clarity);
@@ -717,6 +808,14 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
 
+    // History memory budget in MB, can be overridden for machines with less memory
+    bool hasBudget = false;
+    int historyBudgetMB = qEnvironmentVariableIntValue("IMAGE_PROCESSING_HISTORY_MB", &hasBudget);
+    if (hasBudget && historyBudgetMB > 0)
+    {
+        images.setByteBudget(size_t(historyBudgetMB) * 1024 * 1024);
+    }
+
     MainWindow::setupBtnFunctionalities();
 }
 
@@ -725,38 +824,36 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
-void MainWindow::onImageProcessingSubmit(bool shouldUpdateImages = true)
+void MainWindow::onImageProcessingSubmit(bool shouldUpdateImages, const ImageOperation &operation)
 {
-    QImage qImage = matToQImage(image);
-    cout << "image type() " << image.type() << endl;
-    if (image.type() == CV_32FC1)
-    {
-        image.convertTo(image, CV_8UC1, 255.0);
-    }
-
-    // Update the image gray on every image processing
-    if (image.channels() != 1)
-    {
-        cvtColor(image, imageGrayed, COLOR_RGB2GRAY);
-    }
-    else
-    {
-        image.copyTo(imageGrayed);
-    }
-    ui->currentImageContainer->setPixmap(QPixmap::fromImage(qImage));
-    ui->currentImageContainer->setScaledContents(true);
-
     if (shouldUpdateImages)
     {
-        if (currentImageIndex != images.size() - 1)
+        if (image.type() == CV_32FC1)
         {
-            images.erase(images.begin() + currentImageIndex + 1, images.end());
+            image.convertTo(image, CV_8UC1, 255.0);
         }
 
-        images.push_back(image.clone());
+        images.truncateAfter(currentImageIndex);
+        images.push(image, operation);
         currentImageIndex = images.size() - 1;
+        // image already holds the new revision, its gray plane is derived when a tool asks for it
+        imageRevision = images.revisionId(currentImageIndex);
+        // submitPointOperation continues the chain again once the step is recorded
+        toneChainIndex = -1;
     }
-    cout << "currentImageIndex " << currentImageIndex << endl;
+
+    // the compare modes need the part of the original the view shows
+    Rect2d original;
+    bool canCompare = originalRegion(currentImageIndex, Rect2d(Point2d(), Size2d(images.imageSize(currentImageIndex))), original);
+    if (!canCompare)
+    {
+        QSignalBlocker blocker(ui->compareModeBox);
+        ui->compareModeBox->setCurrentIndex((int)CompareMode::Off);
+    }
+    ui->compareModeBox->setEnabled(canCompare);
+
+    // undo, redo and reset only draw the revision, usually from the pixmap cache
+    showRevision(currentImageIndex);
     if (currentImageIndex == 0)
     {
         ui->undoBtn->setEnabled(false);
@@ -787,6 +884,140 @@ void MainWindow::onImageProcessingSubmit(bool shouldUpdateImages = true)
     }
 }
 
+// region of revision index drawn on the label, from displayCache when it was shown recently
+static QPixmap revisionPixmap(QLabel *label, int index, const Rect2d &region)
+{
+    // rendered at the resolution of the screen from the pyramid level closest to it, the cost
+    // follows the size of the label and not the size of the revision
+    Size displaySize = displaySizeOf(label);
+    unsigned long long revision = images.revisionId(index);
+    for (auto entry = displayCache.begin(); entry != displayCache.end(); entry++)
+    {
+        if (entry->revision == revision && entry->region == region && entry->size == displaySize)
+        {
+            displayCache.splice(displayCache.begin(), displayCache, entry);
+            return entry->pixmap;
+        }
+    }
+
+    shared_ptr<const ImagePyramid> pyramid = images.pyramid(index);
+    QPixmap pixmap;
+    QImage::Format format = displayFormat(pyramid->level(0).type());
+    if (format == QImage::Format_Invalid)
+    {
+        pixmap = QPixmap::fromImage(matToQImage(pyramid->view(region, displaySize)));
+    }
+    else
+    {
+        // the buffer of the previous view is reused while the label keeps its size
+        if (displayBuffer.format() != format || displayBuffer.size() != QSize(displaySize.width, displaySize.height))
+            displayBuffer = QImage(displaySize.width, displaySize.height, format);
+        Mat pixels(displaySize, pyramid->level(0).type(), displayBuffer.bits(), displayBuffer.bytesPerLine());
+        pyramid->view(region, displaySize, pixels);
+        pixmap = QPixmap::fromImage(displayBuffer);
+    }
+    pixmap.setDevicePixelRatio(label->devicePixelRatioF());
+
+    displayCache.push_front({revision, region, displaySize, pixmap});
+    if (displayCache.size() > displayCacheEntries)
+        displayCache.pop_back();
+    return pixmap;
+}
+
+void MainWindow::showRevision(int index)
+{
+    QLabel *label = ui->currentImageContainer;
+    Size displaySize = displaySizeOf(label);
+    if (displaySize.empty())
+        return;
+
+    // the view is in pixels of the current revision, the original shows the same part of the
+    // scene whenever the recorded edits tell where it is
+    double displayScale;
+    Rect2d region = visibleRegion(images.imageSize(currentImageIndex), displaySize, displayScale);
+    Rect2d original;
+    bool hasOriginal = originalRegion(currentImageIndex, region, original);
+
+    if (index == 0)
+    {
+        if (!hasOriginal)
+            original = visibleRegion(images.imageSize(0), displaySize, displayScale);
+        label->setPixmap(revisionPixmap(label, 0, original));
+        return;
+    }
+
+    QPixmap pixmap = revisionPixmap(label, index, region);
+    CompareMode mode = (CompareMode)ui->compareModeBox->currentIndex();
+    if (mode == CompareMode::Off || !hasOriginal)
+    {
+        label->setPixmap(pixmap);
+        return;
+    }
+
+    // both sides come from the cache, only their composition is drawn
+    QPixmap originalPixmap = revisionPixmap(label, 0, original);
+    QPixmap composed = pixmap.copy();
+    QPainter painter(&composed);
+    if (mode == CompareMode::Split)
+    {
+        // target in pixels of the label, source in pixels of the pixmap
+        qreal middle = composed.width() / composed.devicePixelRatio() / 2;
+        qreal height = composed.height() / composed.devicePixelRatio();
+        painter.drawPixmap(QRectF(0, 0, middle, height), originalPixmap, QRectF(0, 0, originalPixmap.width() / 2.0, originalPixmap.height()));
+        painter.setPen(QPen(Qt::white, 1));
+        painter.drawLine(QPointF(middle, 0), QPointF(middle, height));
+    }
+    else
+    {
+        painter.setOpacity(0.5);
+        painter.drawPixmap(QPointF(0, 0), originalPixmap);
+    }
+    painter.end();
+    label->setPixmap(composed);
+}
+
+void MainWindow::onImageContainerScrolled(QPoint position, double steps)
+{
+    if (images.empty())
+        return;
+    Size imageSize = images.imageSize(currentImageIndex);
+
+    QLabel *label = ui->currentImageContainer;
+    Size displaySize(label->contentsRect().width(), label->contentsRect().height());
+    QPoint offset = position - label->contentsRect().topLeft();
+    double displayScale;
+    Rect2d region = visibleRegion(imageSize, displaySize, displayScale);
+
+    // the pixel under the cursor stays under the cursor
+    Point2d anchor(region.x + offset.x() / displayScale, region.y + offset.y() / displayScale);
+    double zoom = min(max(viewZoom * pow(1.25, steps), 1.0), maximumViewZoom);
+    double ratio = viewZoom / zoom;
+    viewCentre = anchor + (Point2d(region.x + region.width / 2, region.y + region.height / 2) - anchor) * ratio;
+    viewZoom = zoom;
+
+    region = visibleRegion(imageSize, displaySize, displayScale);
+    viewCentre = Point2d(region.x + region.width / 2, region.y + region.height / 2);
+    showRevision(currentImageIndex);
+}
+
+void MainWindow::onImageContainerDragged(QPoint offset)
+{
+    if (images.empty())
+        return;
+    Size imageSize = images.imageSize(currentImageIndex);
+
+    QLabel *label = ui->currentImageContainer;
+    Size displaySize(label->contentsRect().width(), label->contentsRect().height());
+    double displayScale;
+    Rect2d region = visibleRegion(imageSize, displaySize, displayScale);
+
+    // kept on the revision, dragging past a border and back doesn't lag behind the cursor
+    viewCentre = Point2d(region.x + region.width / 2 - offset.x() / displayScale, region.y + region.height / 2 - offset.y() / displayScale);
+    region = visibleRegion(imageSize, displaySize, displayScale);
+    viewCentre = Point2d(region.x + region.width / 2, region.y + region.height / 2);
+    showRevision(currentImageIndex);
+}
+
 void MainWindow::enableBtnsOnUpload()
 {
     ui->saveBtn->setEnabled(true);
@@ -810,27 +1041,33 @@ void MainWindow::enableBtnsOnUpload()
     ui->frequencyDomainBtn->setEnabled(true);
     ui->segmentationBtn->setEnabled(true);
     ui->laplacianOfGaussianBtn->setEnabled(true);
+    ui->cannyBtn->setEnabled(true);
+    ui->toneChainBtn->setEnabled(true);
+    ui->compareModeBox->setEnabled(true);
 }
 
 void MainWindow::onUploadBtnClicked()
 {
-    fileName = QFileDialog::getOpenFileName(this, "Open Image File", "", "Images (*.png *.xpm *.jpg *.jpeg *.bmp)");
+    QString selectedName = QFileDialog::getOpenFileName(this, "Open Image File", "", "Images (*.png *.xpm *.jpg *.jpeg *.bmp);;Recipes (*.recipe)");
 
+    if (selectedName.endsWith(".recipe", Qt::CaseInsensitive))
+    {
+        applyRecipe(selectedName);
+        return;
+    }
+
+    fileName = selectedName;
     if (!fileName.isEmpty())
     {
-        image = imread(fileName.toStdString());
-        if (!image.empty())
+        Mat loaded = imread(fileName.toStdString());
+        if (!loaded.empty())
         {
             MainWindow::enableBtnsOnUpload();
-            if (images.empty())
-            {
-                images.push_back(image.clone());
-            }
-            else
-            {
-                images.erase(images.begin(), images.end());
-                images.push_back(image.clone());
-            }
+            image = loaded;
+            images.reset(image);
+            currentImageIndex = 0;
+            imageRevision = images.revisionId(0);
+            resetView(image.size());
             onImageProcessingSubmit(false);
             resetEdit();
         }
@@ -841,12 +1078,78 @@ void MainWindow::onUploadBtnClicked()
     }
 }
 
+void MainWindow::applyRecipe(const QString &recipeName)
+{
+    if (images.empty())
+    {
+        QMessageBox::warning(this, "Error", "Upload an image before applying a recipe.");
+        return;
+    }
+    loadCurrentImage();
+
+    vector<ImageOperation> operations;
+    string error;
+    if (!loadRecipe(recipeName.toStdString(), operations, error))
+    {
+        QMessageBox::warning(this, "Error", QString::fromStdString(error));
+        return;
+    }
+
+    // Every step gets its own revision so the recipe can be undone step by step and saved again,
+    // except runs of flips and warps, which become one warp so the image is resampled once.
+    // A step that doesn't fit this image stops the recipe, the steps before it stay applied.
+    size_t i = 0;
+    try
+    {
+        while (i < operations.size())
+        {
+            size_t end = i + 1;
+            bool hasAffine = operations[i].type == OperationType::Affine;
+            while (isGeometryOperation(operations[i]) && end < operations.size() && isGeometryOperation(operations[end]))
+            {
+                hasAffine = hasAffine || operations[end].type == OperationType::Affine;
+                end++;
+            }
+
+            if (end - i > 1 && hasAffine)
+            {
+                vector<ImageOperation> run(operations.begin() + i, operations.begin() + end);
+                Mat composed = composeGeometryOperations(run, image.size());
+                image = applyGeometryOperations(image, run);
+                onImageProcessingSubmit(true, {OperationType::Affine, 0, {}, composed});
+                i = end;
+                continue;
+            }
+
+            image = applyOperation(image, operations[i]);
+            onImageProcessingSubmit(true, operations[i]);
+            i++;
+        }
+    }
+    catch (const cv::Exception &exception)
+    {
+        string step = "Step " + to_string(i + 1) + " of the recipe, " + formatOperation(operations[i]) + ", failed: " + exception.err;
+        QMessageBox::warning(this, "Error", QString::fromStdString(step));
+    }
+}
+
 void MainWindow::onSaveBtnClicked()
 {
-    QString fileName = QFileDialog::getSaveFileName(this, "Save Image File", "", "Images (*.png *.xpm *.jpg *.jpeg *.bmp)");
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Image File", "", "Images (*.png *.xpm *.jpg *.jpeg *.bmp);;Recipes (*.recipe)");
+
+    if (fileName.endsWith(".recipe", Qt::CaseInsensitive))
+    {
+        string error;
+        if (saveRecipe(fileName.toStdString(), images.operationLog(currentImageIndex), error))
+            QMessageBox::information(this, "Success", "Recipe saved successfully.");
+        else
+            QMessageBox::warning(this, "Error", QString::fromStdString(error));
+        return;
+    }
 
     if (!fileName.isEmpty())
     {
+        loadCurrentImage();
         bool saved = imwrite(fileName.toStdString(), image);
 
         if (saved)
@@ -858,47 +1161,73 @@ void MainWindow::onSaveBtnClicked()
 
 void MainWindow::onImagePropertiesBtnClicked()
 {
+    loadCurrentImage();
     auto [total, rows, cols, depth] = imageDetails(image);
-    auto [min, max, avg] = imageMinMaxAvg(image);
+
+    // read from the revision's cached statistics, computed once with 64 bit counts
+    shared_ptr<const ImageAnalytics> analytics = images.analytics(currentImageIndex);
+    static const vector<string> bgrNames = {"Blue", "Green", "Red", "Alpha"};
+
+    string channelDetails;
+    for (size_t c = 0; c < analytics->mean.size(); c++)
+    {
+        char line[160];
+        snprintf(line, sizeof(line), "%s: min %g, max %g, mean %.2f, std dev %.2f\n",
+                 analytics->mean.size() == 1 ? "Gray" : bgrNames[c % 4].c_str(),
+                 analytics->minimum[c], analytics->maximum[c], analytics->mean[c], analytics->stddev[c]);
+        channelDetails += line;
+    }
+
+    size_t bits = imgSize(image);
     QMessageBox msgBox;
     msgBox.setWindowTitle("Image Properties");
-    msgBox.setText(QString::fromStdString("Path: " + fileName.toStdString() + "\n" + "Dimensions (RowsXCols): " + to_string(rows) + "x" + to_string(cols) + "\n" + "Total pixels: " + to_string(total) + "\n" + "Depth code: " + to_string(depth) + "\n" + "Minimum pixel value: " + to_string(min) + "\n" + "Maximum pixel value: " + to_string(max) + "\n" + "Dynamic range: (" + to_string(min) + ", " + to_string(max) + ")" + "\n" + "Average pixel value: " + to_string(avg) + "\n" + "Total number of bits required to store the image: " + to_string(imgSize(image))));
+    msgBox.setText(QString::fromStdString("Path: " + fileName.toStdString() + "\n" + "Dimensions (RowsXCols): " + to_string(rows) + "x" + to_string(cols) + "\n" + "Total pixels: " + to_string(total) + "\n" + "Channels: " + to_string(image.channels()) + "\n" + "Depth code: " + to_string(depth) + " (" + to_string(imageDepth2Bits(depth)) + " bits)" + "\n" + channelDetails + "Entropy: " + to_string(analytics->entropy) + " bits/pixel" + "\n" + "Total number of bits required to store the image: " + to_string(bits) + " (" + to_string(bits / 8 / 1024) + " KB)"));
     msgBox.setStyleSheet("QLabel{min-width:500px; font-size: 18px;} QPushButton{ width:250px; font-size: 16px; }");
+
+    string histogramWindowName = "Histogram";
+    if (!analytics->channelHistograms.empty())
+        imshow(histogramWindowName, histogramImage(analytics->channelHistograms));
     msgBox.exec();
+    if (!analytics->channelHistograms.empty())
+        destroyWindow(histogramWindowName);
 }
 
 void MainWindow::onCvtGrayBtnClicked()
 {
+    loadCurrentImage();
     if (image.channels() == 1)
     {
         QMessageBox::warning(this, "Error", "Image is already in grayscale.");
         return;
     }
 
-    cvtColor(image, image, COLOR_RGB2GRAY);
-    onImageProcessingSubmit();
+    image = grayscaleOf(image);
+    onImageProcessingSubmit(true, {OperationType::ConvertToGray});
 }
 
 void MainWindow::onImageContainerClicked()
 {
-    if (image.empty())
+    if (images.empty())
     {
         QMessageBox::warning(this, "Error", "No image to show. Please upload Image");
         return;
     }
+    loadCurrentImage();
 
     showImage("Image", image);
 }
 
 void MainWindow::onTranslateBtnClicked()
 {
+    loadCurrentImage();
     resetEdit();
     string windowName = "Adjust position";
     namedWindow(windowName, WINDOW_NORMAL);
 
     // Register a mouse callback
     setMouseCallback(windowName, translateWindowMouseHandler, nullptr);
-    image.copyTo(dstTranslatedImage);
+    startPreview();
+    previewImage.copyTo(dstTranslatedImage);
 
     // Loop until the user input the termination input
     while (!didEditFinish)
@@ -911,18 +1240,23 @@ void MainWindow::onTranslateBtnClicked()
             destroyWindow(windowName);
             return;
         }
+
+        if (composeFlipKey(keyCode))
+            dstTranslatedImage = affineTransform(previewImage, previewMatrix(affineMatrix));
     }
     destroyWindow(windowName);
-    onImageProcessingSubmit();
+    onImageProcessingSubmit(true, {OperationType::Affine, 0, {}, affineMatrix.clone()});
 }
 
 void MainWindow::onRotateBtnClicked()
 {
+    loadCurrentImage();
     resetEdit();
     string windowName = "Adjust Rotation";
     namedWindow(windowName, WINDOW_NORMAL);
     setMouseCallback(windowName, rotationWindowMouseHandler, nullptr);
-    image.copyTo(dstRotatedImage);
+    startPreview();
+    previewImage.copyTo(dstRotatedImage);
 
     while (!didEditFinish)
     {
@@ -934,26 +1268,31 @@ void MainWindow::onRotateBtnClicked()
             destroyWindow(windowName);
             return;
         }
+
+        if (composeFlipKey(keyCode))
+            dstRotatedImage = affineTransform(previewImage, previewMatrix(affineMatrix));
     }
-    onImageProcessingSubmit();
+    onImageProcessingSubmit(true, {OperationType::Affine, 0, {}, affineMatrix.clone()});
 
     destroyWindow(windowName);
 }
 
 void MainWindow::onFlipBtnClicked()
 {
+    loadCurrentImage();
     int flipOption = showFlipPopup();
     if (flipOption == -2)
     {
         return;
     }
 
-    flip(image, image, flipOption);
-    onImageProcessingSubmit();
+    image = flipImage(image, flipOption);
+    onImageProcessingSubmit(true, {OperationType::Flip, flipOption});
 }
 
 void MainWindow::onBrightnessAdjustBtnClicked()
 {
+    loadCurrentImage();
     resetEdit();
     string windowName = "Adjust Brightness";
     namedWindow(windowName, WINDOW_AUTOSIZE);
@@ -961,6 +1300,7 @@ void MainWindow::onBrightnessAdjustBtnClicked()
     TrackbarWindowData userData;
     imageGrayed.copyTo(userData.dstImage);
     userData.image = imageGrayed.clone();
+    userData.histogram = images.analytics(currentImageIndex)->grayHistogram;
     userData.windowName = windowName;
     userData.mainWindow = this;
 
@@ -968,30 +1308,15 @@ void MainWindow::onBrightnessAdjustBtnClicked()
                    {
                    // Map the trackbar value to the range -10 to 10
                    float gammaValue = (value * 1.0) / 50.0 ;
-                   cout << "Gamma Value: " << gammaValue << endl;
 
                    // Access the image from userData
                    TrackbarWindowData *data = (TrackbarWindowData *)userData;
                    cv::Mat &image = data->image;
-                    cv::Mat &dstImage = data->dstImage;
-                    image.copyTo(dstImage);
-
-                   int imageBits = imageDepth2Bits(dstImage.depth());
-                   int maxPixelValue = pow(2, imageBits) - 1;
+                   cv::Mat &dstImage = data->dstImage;
 
-                   dstImage.convertTo(dstImage, CV_32F);
-
-                   for (int i = 0; i < dstImage.rows; i++)
-                   {
-                       for (int j = 0; j < dstImage.cols; j++)
-                       {
-                           float pixelValue = dstImage.at<float>(i, j);
-                           dstImage.at<float>(i, j) = pow(pixelValue, gammaValue);
-                       }
-                   }
-
-                   normalize(dstImage, dstImage, 0, maxPixelValue, NORM_MINMAX);
-                   convertScaleAbs(dstImage, dstImage);
+                   // only the 256 entry table is rebuilt on every move
+                   LUT(image, gammaLut(gammaValue, data->histogram), dstImage);
+                   data->operation = {OperationType::Brightness, 0, {gammaValue}};
 
                    imshow(data->windowName, dstImage); }, &userData);
     setTrackbarPos("Brightness", windowName, 50);
@@ -1014,111 +1339,127 @@ waiting_key:
 
 void MainWindow::onHistogramEqBtnClicked()
 {
-    equalizeHist(imageGrayed, image);
-    onImageProcessingSubmit();
+    submitPointOperation({OperationType::HistogramEqualization});
 }
 
 void MainWindow::onNegativeBtnClicked()
 {
-    Mat dstImage = imageGrayed.clone();
+    submitPointOperation({OperationType::Negative});
+}
 
-    for (int i = 0; i < dstImage.rows; i++)
-    {
-        for (int j = 0; j < dstImage.cols; j++)
-        {
-            int pixelValue = dstImage.at<uchar>(i, j);
-            int maxPixelValue = pow(2, imageDepth2Bits(dstImage.depth())) - 1;
-            dstImage.at<uchar>(i, j) = maxPixelValue - pixelValue;
-        }
-    }
+void MainWindow::onLogTransformationBtnClicked()
+{
+    submitPointOperation({OperationType::LogTransformation});
+}
 
-    dstImage.copyTo(image);
-    onImageProcessingSubmit();
+void MainWindow::onBitSlicingBtnClicked()
+{
+    submitPointOperation({OperationType::BitSlicing});
 }
 
-void MainWindow::onLogTransformationBtnClicked()
+void MainWindow::submitPointOperation(const ImageOperation &operation)
 {
-    Mat dstImage = imageGrayed.clone();
-    int imageBits = imageDepth2Bits(dstImage.depth());
-    int maxPixelValue = pow(2, imageBits) - 1;
+    loadCurrentImage();
+    // the histogram the normalizing operations need is cached with the revision
+    shared_ptr<const ImageAnalytics> analytics = images.analytics(currentImageIndex);
 
-    dstImage.convertTo(dstImage, CV_32F);
+    if (!ui->toneChainBtn->isChecked())
+    {
+        image = applyLut(imageGrayed, pointOperationLut(operation, analytics->grayHistogram));
+        onImageProcessingSubmit(true, operation);
+        return;
+    }
 
-    for (int i = 0; i < dstImage.rows; i++)
+    // undo, redo or any other edit since the last step start a new chain from the current revision
+    if (toneChainIndex != currentImageIndex)
     {
-        for (int j = 0; j < dstImage.cols; j++)
-        {
-            int pixelValue = dstImage.at<float>(i, j);
-            dstImage.at<float>(i, j) = log(pixelValue + 1);
-        }
+        toneChainBase = imageGrayed;
+        toneChainHistogram = analytics->grayHistogram;
+        toneChainLut = identityLut();
     }
 
-    normalize(dstImage, dstImage, 0, maxPixelValue, NORM_MINMAX);
-    convertScaleAbs(dstImage, dstImage);
-    dstImage.copyTo(image);
-    onImageProcessingSubmit();
+    // only the 256 entries change, the base is traversed once however long the chain is
+    toneChainLut = composeLuts(toneChainLut, compilePointOperations({operation}, toneChainHistogram));
+    image = applyLut(toneChainBase, toneChainLut);
+    onImageProcessingSubmit(true, operation);
+    toneChainIndex = currentImageIndex;
+
+    imshow(toneCurveWindowName, lutCurveImage(toneChainLut));
 }
 
-void MainWindow::onBitSlicingBtnClicked()
+void MainWindow::onToneChainBtnToggled(bool checked)
 {
-    Mat dstImage = imageGrayed.clone();
-    int maxPixelValue = pow(2, imageDepth2Bits(dstImage.depth()));
-    int msbValue = maxPixelValue / 2;
+    toneChainIndex = -1;
 
-    for (int i = 0; i < dstImage.rows; i++)
-    {
-        for (int j = 0; j < dstImage.cols; j++)
-        {
-            int pixelValue = dstImage.at<uchar>(i, j);
-            dstImage.at<uchar>(i, j) = pixelValue & msbValue ? 255 : 0;
-        }
-    }
-
-    dstImage.copyTo(image);
-    onImageProcessingSubmit();
+    if (checked)
+        imshow(toneCurveWindowName, lutCurveImage(identityLut()));
+    else
+        destroyWindow(toneCurveWindowName);
 }
 
-void MainWindow::onZoomBtnClicked()
+void MainWindow::onCropToViewBtnClicked()
 {
+    loadCurrentImage();
     resetEdit();
-    string windowName = "Zoom Image";
-    namedWindow(windowName, WINDOW_NORMAL);
-    image.copyTo(dstZoomedImage);
-    imshow(windowName, dstZoomedImage);
-
-    ZoomData zoomData;
 
-    zoomData.rectangleSize = 100;
-
-    setMouseCallback(windowName, zoomWindowMouseHandler, &zoomData);
-
-    while (!didEditFinish)
+    QLabel *label = ui->currentImageContainer;
+    double displayScale;
+    Rect2d region = visibleRegion(image.size(), Size(label->contentsRect().width(), label->contentsRect().height()), displayScale);
+    Rect crop = Rect(Point(cvFloor(region.x), cvFloor(region.y)), Point(cvCeil(region.br().x), cvCeil(region.br().y))) & Rect(0, 0, image.cols, image.rows);
+    if (crop.empty() || crop.size() == image.size())
     {
-        imshow(windowName, dstZoomedImage);
-        int keyCode = waitKey(5);
-
-        if (keyCode == KeyCodes::ESC)
-        {
-            images[currentImageIndex].copyTo(image);
-            destroyWindow(windowName);
-            return;
-        }
+        QMessageBox::information(this, "Crop to View", "Scroll on the image to zoom in and drag it to choose the part to keep.");
+        return;
     }
-    destroyWindow(windowName);
-    dstZoomedImage.copyTo(image);
-    onImageProcessingSubmit();
+
+    ImageOperation operation;
+    operation.type = OperationType::Crop;
+    operation.regions.push_back(crop);
+    image = applyOperation(image, operation);
+    // the crop is what was shown, fitted to the label it looks the same
+    resetView(image.size());
+    onImageProcessingSubmit(true, operation);
 }
 
 void MainWindow::onAreaOfInterestBtnClicked()
 {
+    loadCurrentImage();
+    ZoomData data;
+    data.rectangleSize = 100;
+    data.operation.type = OperationType::AreaOfInterest;
+
+    QMessageBox msgBox;
+    msgBox.setWindowTitle("Select Option");
+    msgBox.setText("Gray levels outside the area of interest:");
+    msgBox.setStandardButtons(QMessageBox::Close);
+    QPushButton *blackButton = msgBox.addButton("Black", QMessageBox::NoRole);
+    QPushButton *keepButton = msgBox.addButton("Keep original", QMessageBox::NoRole);
+    msgBox.exec();
+
+    if (msgBox.clickedButton() == blackButton)
+    {
+        data.operation.option = 0;
+    }
+    else if (msgBox.clickedButton() == keepButton)
+    {
+        data.operation.option = 1;
+    }
+    else
+    {
+        return;
+    }
+
     resetEdit();
     string windowName = "Area of Interest";
     namedWindow(windowName, WINDOW_AUTOSIZE);
     imageGrayed.copyTo(dstAreaOfInterestImage);
     imshow(windowName, dstAreaOfInterestImage);
 
-    ZoomData data;
-    data.rectangleSize = 100;
+    // region histograms are answered from the block sums instead of rereading the pixels
+    areaOfInterestBase = imageGrayed;
+    areaOfInterestLut = identityLut();
+    areaOfInterestHistogram = IntegralHistogram(imageGrayed);
+
     setMouseCallback(windowName, areaOfInterestMouseHandler, &data);
 
     while (!didEditFinish)
@@ -1128,15 +1469,8 @@ void MainWindow::onAreaOfInterestBtnClicked()
 
         if (keyCode == KeyCodes::ESC)
         {
-            images[currentImageIndex].copyTo(image);
-            if (image.channels() != 1)
-            {
-                cvtColor(image, imageGrayed, COLOR_RGB2GRAY);
-            }
-            else
-            {
-                image.copyTo(imageGrayed);
-            }
+            images.at(currentImageIndex).copyTo(image);
+            imageGrayed = images.grayPlane(currentImageIndex);
             destroyWindow(windowName);
             return;
         }
@@ -1144,16 +1478,18 @@ void MainWindow::onAreaOfInterestBtnClicked()
 
     destroyWindow(windowName);
     dstAreaOfInterestImage.copyTo(image);
-    onImageProcessingSubmit();
+    onImageProcessingSubmit(true, data.operation);
 }
 
 void MainWindow::onDeSkewBtnClicked()
 {
+    loadCurrentImage();
     // Show the image
     resetEdit();
     string windowName = "Select Points";
     namedWindow(windowName, WINDOW_AUTOSIZE);
-    image.copyTo(dstDeSkewedImage);
+    startPreview();
+    previewImage.copyTo(dstDeSkewedImage);
     imshow(windowName, dstDeSkewedImage);
 
     // Set the mouse callback function
@@ -1172,15 +1508,21 @@ void MainWindow::onDeSkewBtnClicked()
     }
 
     destroyWindow(windowName);
-    dstDeSkewedImage.copyTo(image);
-    onImageProcessingSubmit();
+
+    // the markers are only drawn on the preview, without three point pairs there is nothing to apply
+    if (srcPoints.size() < 3 || dstPoints.size() < 3)
+        return;
+
+    image = affineTransform(image, affineMatrix);
+    onImageProcessingSubmit(true, {OperationType::Affine, 0, {}, affineMatrix.clone()});
 }
 
 void MainWindow::onSmoothingBtnClicked()
 {
-
+    loadCurrentImage();
     ZoomData data;
     data.rectangleSize = 100;
+    data.operation.type = OperationType::Smoothing;
 
     QMessageBox msgBox;
     msgBox.setWindowTitle("Select The Smoothing Filter");
@@ -1196,24 +1538,25 @@ void MainWindow::onSmoothingBtnClicked()
 
     if (msgBox.clickedButton() == traditionalFilter)
     {
-        data.kernel = traditionalKernel3x3.clone();
+        data.operation.option = (int)SmoothingLevel::Traditional3x3;
     }
     else if (msgBox.clickedButton() == pyramidalFilter)
     {
-        data.kernel = pyramidalKernel5x5.clone();
+        data.operation.option = (int)SmoothingLevel::Pyramidal5x5;
     }
     else if (msgBox.clickedButton() == circularFilter)
     {
-        data.kernel = circularKernel5x5.clone();
+        data.operation.option = (int)SmoothingLevel::Circular5x5;
     }
     else if (msgBox.clickedButton() == coneFilter)
     {
-        data.kernel = coneKernel5x5.clone();
+        data.operation.option = (int)SmoothingLevel::Cone5x5;
     }
     else
     {
         return;
     }
+    data.kernel = smoothingKernel((SmoothingLevel)data.operation.option);
 
     resetEdit();
     string windowName = "Smoothing Filters";
@@ -1230,15 +1573,8 @@ void MainWindow::onSmoothingBtnClicked()
 
         if (keyCode == KeyCodes::ESC)
         {
-            images[currentImageIndex].copyTo(image);
-            if (image.channels() != 1)
-            {
-                cvtColor(image, imageGrayed, COLOR_RGB2GRAY);
-            }
-            else
-            {
-                image.copyTo(imageGrayed);
-            }
+            images.at(currentImageIndex).copyTo(image);
+            imageGrayed = images.grayPlane(currentImageIndex);
             destroyWindow(windowName);
             return;
         }
@@ -1246,20 +1582,76 @@ void MainWindow::onSmoothingBtnClicked()
 
     destroyWindow(windowName);
     dstSmoothedImage.copyTo(image);
-    onImageProcessingSubmit();
+
+    // a smoothing operation without regions would smooth the whole image on replay
+    onImageProcessingSubmit(true, data.operation.regions.empty() ? ImageOperation() : data.operation);
 }
 
 void MainWindow::onMedianBtnClicked()
 {
-    Mat dstImage;
+    loadCurrentImage();
+    bool isColour = false;
+    if (image.channels() > 1)
+    {
+        QMessageBox msgBox;
+        msgBox.setWindowTitle("Median Filter");
+        msgBox.setText("Filter the gray levels or every colour channel:");
+        msgBox.setStandardButtons(QMessageBox::Close);
+        QPushButton *grayBtn = msgBox.addButton("Gray", QMessageBox::NoRole);
+        QPushButton *colourBtn = msgBox.addButton("Colour", QMessageBox::NoRole);
+        msgBox.exec();
+
+        if (msgBox.clickedButton() == colourBtn)
+            isColour = true;
+        else if (msgBox.clickedButton() != grayBtn)
+            return;
+    }
+
+    medianRadius = 1;
+    resetEdit();
+    string windowName = "Median Filter";
+    namedWindow(windowName, WINDOW_AUTOSIZE);
 
-    medianBlur(imageGrayed, dstImage, 3);
-    dstImage.copyTo(image);
-    onImageProcessingSubmit();
+    TrackbarWindowData userData;
+    userData.image = isColour ? image.clone() : imageGrayed;
+    userData.windowName = windowName;
+    userData.mainWindow = this;
+    setMouseCallback(windowName, proxyPreviewMouseHandler, &userData);
+
+    Mat proxy = previewProxy(userData.image, previewSide);
+    double proxyScale = (double)proxy.cols / userData.image.cols;
+    imshow(windowName, proxy);
+
+    createTrackbar("Radius", windowName, nullptr, 50, [](int value, void *userData)
+                   { medianRadius = value; }, nullptr);
+    setTrackbarPos("Radius", windowName, medianRadius);
+    setTrackbarMin("Radius", windowName, 1);
+
+    int shownRadius = -1;
+
+    while (!didEditFinish)
+    {
+        if (medianRadius != shownRadius)
+        {
+            shownRadius = medianRadius;
+            userData.operation = {OperationType::Median, isColour ? 1 : 0, {(double)(2 * shownRadius + 1)}};
+            int proxyRadius = max(1, cvRound(shownRadius * proxyScale));
+            imshow(windowName, medianFilter(proxy, 2 * proxyRadius + 1));
+        }
+
+        int keyCode = waitKey(5);
+
+        if (keyCode == KeyCodes::ESC)
+        {
+            destroyWindow(windowName);
+            break;
+        }
+    }
 }
 
 void MainWindow::onSobelBtnClicked()
 {
+    loadCurrentImage();
     QMessageBox msgBox;
     msgBox.setWindowTitle("Select Filter Orientation");
     msgBox.setText("Select the orientation of the Edge detection filter:");
@@ -1267,60 +1659,65 @@ void MainWindow::onSobelBtnClicked()
     QPushButton *horizontalBtn = msgBox.addButton("Horizontal", QMessageBox::NoRole);
     QPushButton *verticalBtn = msgBox.addButton("Vertical", QMessageBox::NoRole);
     QPushButton *bothBtn = msgBox.addButton("Both", QMessageBox::NoRole);
+    QPushButton *directionBtn = msgBox.addButton("Direction", QMessageBox::NoRole);
 
     msgBox.exec();
 
+    SobelOrientation orientation;
     if (msgBox.clickedButton() == horizontalBtn)
     {
-        Mat dstImage;
-        Sobel(imageGrayed, dstImage, CV_16UC1, 0, 1, 5);
-        convertScaleAbs(dstImage, dstImage);
-        dstImage.copyTo(image);
-        onImageProcessingSubmit();
+        orientation = SobelOrientation::Horizontal;
     }
-
-    if (msgBox.clickedButton() == verticalBtn)
+    else if (msgBox.clickedButton() == verticalBtn)
     {
-        Mat dstImage;
-        Sobel(imageGrayed, dstImage, CV_16UC1, 1, 0, 5);
-        convertScaleAbs(dstImage, dstImage);
-        dstImage.copyTo(image);
-        onImageProcessingSubmit();
+        orientation = SobelOrientation::Vertical;
     }
-
-    if (msgBox.clickedButton() == bothBtn)
+    else if (msgBox.clickedButton() == bothBtn)
     {
-        Mat dstImage;
-        Mat dstImageH;
-        Mat dstImageV;
-        Sobel(imageGrayed, dstImageH, CV_16UC1, 0, 1, 5);
-        convertScaleAbs(dstImageH, dstImageH);
-        Sobel(imageGrayed, dstImageV, CV_16UC1, 1, 0, 5);
-        convertScaleAbs(dstImageV, dstImageV);
-        addWeighted(dstImageH, 1, dstImageV, 1, 0, dstImage);
-        dstImage.copyTo(image);
-        onImageProcessingSubmit();
+        orientation = SobelOrientation::Both;
     }
+    else if (msgBox.clickedButton() == directionBtn)
+    {
+        orientation = SobelOrientation::Direction;
+    }
+    else
+    {
+        return;
+    }
+
+    sobelEdges(imageGrayed, orientation).copyTo(image);
+    onImageProcessingSubmit(true, {OperationType::Sobel, (int)orientation});
 }
 
 void MainWindow::onFrequencyDomainBtnClicked()
 {
-    int isLowPassFilter = 0;
+    loadCurrentImage();
+    FrequencyBand band;
     QMessageBox msgBox;
     msgBox.setWindowTitle("Frequency Domain Filters");
     msgBox.setText("Select the filter you want to apply:");
     msgBox.setStandardButtons(QMessageBox::Close);
     QPushButton *lowPassFilter = msgBox.addButton("Smoothen && Blurring", QMessageBox::NoRole);
     QPushButton *highPassFilter = msgBox.addButton("Sharpen && Enhancing", QMessageBox::NoRole);
+    QPushButton *bandPassFilter = msgBox.addButton("Band Pass", QMessageBox::NoRole);
+    QPushButton *bandStopFilter = msgBox.addButton("Band Stop", QMessageBox::NoRole);
     msgBox.exec();
 
     if (msgBox.clickedButton() == lowPassFilter)
     {
-        isLowPassFilter = 1;
+        band = FrequencyBand::LowPass;
     }
     else if (msgBox.clickedButton() == highPassFilter)
     {
-        isLowPassFilter = 0;
+        band = FrequencyBand::HighPass;
+    }
+    else if (msgBox.clickedButton() == bandPassFilter)
+    {
+        band = FrequencyBand::BandPass;
+    }
+    else if (msgBox.clickedButton() == bandStopFilter)
+    {
+        band = FrequencyBand::BandStop;
     }
     else
     {
@@ -1328,107 +1725,84 @@ void MainWindow::onFrequencyDomainBtnClicked()
     }
 
     d0 = 50;
+    frequencyShape = (int)FrequencyFilterShape::Ideal;
+    frequencyOrder = 2;
+    frequencyWidth = 20;
     resetEdit();
-    string windowName = "To be determined";
+    string windowName = "Frequency Domain Filter";
     namedWindow(windowName, WINDOW_AUTOSIZE);
-    imageGrayed.copyTo(dstFrequencyDomainImage);
-    imshow(windowName, dstFrequencyDomainImage);
+    namedWindow(frequencySpectrumWindowName, WINDOW_AUTOSIZE);
+    Mat proxy = previewProxy(imageGrayed, previewSide);
+    imshow(windowName, proxy);
+
     createTrackbar("d0", windowName, nullptr, 255, [](int value, void *userData)
                    { d0 = value; }, nullptr);
     setTrackbarPos("d0", windowName, 50);
     setTrackbarMax("d0", windowName, 255);
     setTrackbarMin("d0", windowName, 1);
 
+    // 0 ideal, 1 gaussian, 2 butterworth
+    createTrackbar("Shape", windowName, nullptr, 2, [](int value, void *userData)
+                   { frequencyShape = value; }, nullptr);
+    setTrackbarPos("Shape", windowName, frequencyShape);
+
+    createTrackbar("Order", windowName, nullptr, 10, [](int value, void *userData)
+                   { frequencyOrder = value; }, nullptr);
+    setTrackbarPos("Order", windowName, frequencyOrder);
+    setTrackbarMin("Order", windowName, 1);
+
+    if (band == FrequencyBand::BandPass || band == FrequencyBand::BandStop)
+    {
+        createTrackbar("Width", windowName, nullptr, 255, [](int value, void *userData)
+                       { frequencyWidth = value; }, nullptr);
+        setTrackbarPos("Width", windowName, frequencyWidth);
+        setTrackbarMin("Width", windowName, 1);
+    }
+
     TrackbarWindowData userData;
-    userData.image = imageGrayed.clone();
-    userData.dstImage = dstFrequencyDomainImage;
     userData.windowName = windowName;
     userData.mainWindow = this;
     setMouseCallback(windowName, frequencyDomainMouseHandler, &userData);
 
+    // the spectrum of the proxy is computed once, changing a parameter only applies the new
+    // response and runs the inverse transform
+    FrequencyDomainSession session(proxy, imageGrayed.size());
+    FrequencyFilter shownFilter;
+    bool isShown = false;
+
     while (!didEditFinish)
     {
-        Mat srcImage = imageGrayed.clone();
-        int m = getOptimalDFTSize(srcImage.rows);
-        int n = getOptimalDFTSize(srcImage.cols);
-        Mat padded;
-        copyMakeBorder(srcImage, padded, 0, m - srcImage.rows, 0, n - srcImage.cols, BorderTypes::BORDER_CONSTANT);
-        int maxPixelValue = pow(2, imageDepth2Bits(srcImage.depth())) - 1;
-        padded.convertTo(padded, CV_32FC1, 1.0 / (maxPixelValue * 1.0));
-        Mat planes[2] = {padded, Mat::zeros(padded.size(), CV_32FC1)};
-        Mat complexI;
-        merge(planes, 2, complexI);
-        dft(complexI, complexI);
-        split(complexI, planes);
-
-        // DFT Pre-processing
-        int cx = complexI.cols / 2; // n / 2
-        int cy = complexI.rows / 2; // m / 2
-        // Divide into 4 quarter
-        Mat p1(complexI, Rect(0, 0, cx, cy));
-        Mat p2(complexI, Rect(cx, 0, cx, cy));
-        Mat p3(complexI, Rect(0, cy, cx, cy));
-        Mat p4(complexI, Rect(cx, cy, cx, cy));
-
-        Mat temp;
-        p1.copyTo(temp);
-        p4.copyTo(p1);
-        temp.copyTo(p4);
-
-        p2.copyTo(temp);
-        p3.copyTo(p2);
-        temp.copyTo(p3);
-        split(complexI, planes);
-
-        // Create Filter Matrix
-        Mat filter(complexI.size(), CV_32FC1);
-        for (int i = 0; i < filter.rows; i++)
+        FrequencyFilter filter;
+        filter.band = band;
+        filter.shape = (FrequencyFilterShape)frequencyShape;
+        filter.d0 = d0;
+        filter.width = frequencyWidth;
+        filter.order = frequencyOrder;
+
+        if (!isShown || !(filter == shownFilter))
         {
-            for (int j = 0; j < filter.cols; j++)
-            {
-                double z1 = i - filter.rows / 2;
-                double z2 = j - filter.cols / 2;
-                if (sqrt(pow(z1, 2) + pow(z2, 2)) < d0)
-                {
-                    filter.at<float>(i, j) = isLowPassFilter ? 1 : 0;
-                }
-                else
-                    filter.at<float>(i, j) = isLowPassFilter ? 0 : 1;
-            }
+            shownFilter = filter;
+            isShown = true;
+            dstFrequencyDomainImage = session.filter(filter);
+            userData.operation = frequencyDomainOperation(filter);
+            imshow(windowName, dstFrequencyDomainImage);
+            imshow(frequencySpectrumWindowName, session.spectrumImage());
         }
 
-        // Apply filter
-        // Split was done previously
-        multiply(planes[0], filter, planes[0]);
-        multiply(planes[1], filter, planes[1]);
-        merge(planes, 2, complexI);
-        idft(complexI, complexI);
-
-        // DFT post-processing & visualization
-        split(complexI, planes);
-        magnitude(planes[0], planes[1], dstFrequencyDomainImage);
-        normalize(dstFrequencyDomainImage, dstFrequencyDomainImage, 0, 1, NORM_MINMAX);
-        imshow(windowName, dstFrequencyDomainImage);
-        dstFrequencyDomainImage.copyTo(userData.dstImage);
-
-    waiting_key:
-        int keyCode = waitKey(0);
+        int keyCode = waitKey(5);
 
         if (keyCode == KeyCodes::ESC)
         {
             destroyWindow(windowName);
+            destroyWindow(frequencySpectrumWindowName);
             break;
         }
-
-        if (keyCode != KeyCodes::ENTER)
-        {
-            goto waiting_key;
-        }
     }
 }
 
 void MainWindow::onSegmentationBtnClicked()
 {
+    loadCurrentImage();
     resetEdit();
     int t0 = 80;
 
@@ -1442,29 +1816,8 @@ void MainWindow::onSegmentationBtnClicked()
 
     if (msgBox.clickedButton() == automaticBtn)
     {
-        int pixelValues = 0;
-
-        // calculate t0
-        for (int i = 0; i < imageGrayed.rows; i++)
-        {
-            for (int j = 0; j < imageGrayed.cols; j++)
-            {
-                pixelValues += imageGrayed.at<uchar>(i, j);
-            }
-        }
-
-        t0 = pixelValues / imageGrayed.total();
-        imageGrayed.copyTo(image);
-
-        for (int i = 0; i < imageGrayed.rows; i++)
-        {
-            for (int j = 0; j < imageGrayed.cols; j++)
-            {
-                image.at<uchar>(i, j) = imageGrayed.at<uchar>(i, j) > t0 ? 255 : 0;
-            }
-        }
-
-        onImageProcessingSubmit();
+        t0 = histogramMean(images.analytics(currentImageIndex)->grayHistogram);
+        submitPointOperation({OperationType::Segmentation, 0, {(double)t0}});
     }
 
     if (msgBox.clickedButton() == manualBtn)
@@ -1504,13 +1857,8 @@ void MainWindow::onSegmentationBtnClicked()
         // segmentation Thresholding, manually calculated T0
         while (attempts <= 10 && !didEditFinish)
         {
-            for (int i = 0; i < imageGrayed.rows; i++)
-            {
-                for (int j = 0; j < imageGrayed.cols; j++)
-                {
-                    userData.dstImage.at<uchar>(i, j) = imageGrayed.at<uchar>(i, j) > t0 ? 255 : 0;
-                }
-            }
+            thresholdSegmentation(imageGrayed, t0).copyTo(userData.dstImage);
+            userData.operation = {OperationType::Segmentation, 0, {(double)t0}};
             imshow(windowName, userData.dstImage);
 
         waiting_key:
@@ -1543,7 +1891,7 @@ void MainWindow::onSegmentationBtnClicked()
             {
                 destroyWindow(windowName);
                 userData.dstImage.copyTo(image);
-                onImageProcessingSubmit();
+                onImageProcessingSubmit(true, userData.operation);
             }
             else
             {
@@ -1555,33 +1903,136 @@ void MainWindow::onSegmentationBtnClicked()
 
 void MainWindow::onLaplacianOfGaussianBtnClicked()
 {
+    loadCurrentImage();
+    laplacianSigma = 2;
+    laplacianScales = 1;
+    laplacianContrast = 8;
+    resetEdit();
+    string windowName = "Laplacian of Gaussian";
+    namedWindow(windowName, WINDOW_AUTOSIZE);
+    Mat proxy = previewProxy(imageGrayed, previewSide);
+    // sigmas are in pixels of the full resolution image
+    double proxyScale = (double)proxy.cols / imageGrayed.cols;
+    imshow(windowName, proxy);
+
+    createTrackbar("Sigma", windowName, nullptr, 32, [](int value, void *userData)
+                   { laplacianSigma = value; }, nullptr);
+    setTrackbarPos("Sigma", windowName, laplacianSigma);
+    setTrackbarMin("Sigma", windowName, 1);
+
+    createTrackbar("Scales", windowName, nullptr, 4, [](int value, void *userData)
+                   { laplacianScales = value; }, nullptr);
+    setTrackbarPos("Scales", windowName, laplacianScales);
+    setTrackbarMin("Scales", windowName, 1);
+
+    createTrackbar("Contrast", windowName, nullptr, 64, [](int value, void *userData)
+                   { laplacianContrast = value; }, nullptr);
+    setTrackbarPos("Contrast", windowName, laplacianContrast);
+
+    TrackbarWindowData userData;
+    userData.image = imageGrayed;
+    userData.windowName = windowName;
+    userData.mainWindow = this;
+    setMouseCallback(windowName, proxyPreviewMouseHandler, &userData);
 
-    // Edge Detection
-    filter2D(imageGrayed, image, CV_8UC1, laplacianOfGaussianKernel);
-    onImageProcessingSubmit();
+    // the pyramid of the proxy is built once, a new sigma only filters the octave it falls on
+    ScaleSpace scaleSpace(proxy);
+    int shownSigma = -1, shownScales = -1, shownContrast = -1;
+
+    while (!didEditFinish)
+    {
+        if (laplacianSigma != shownSigma || laplacianScales != shownScales || laplacianContrast != shownContrast)
+        {
+            shownSigma = laplacianSigma;
+            shownScales = laplacianScales;
+            shownContrast = laplacianContrast;
+            userData.operation = {OperationType::LaplacianOfGaussian, 0, {(double)shownContrast}};
+
+            Mat edges = Mat::zeros(proxy.size(), CV_8UC1);
+            for (int i = 0; i < shownScales; i++)
+            {
+                double sigma = shownSigma << i;
+                userData.operation.values.push_back(sigma);
+                bitwise_or(edges, zeroCrossings(scaleSpace.laplacian(sigma * proxyScale), sigma * proxyScale, shownContrast), edges);
+            }
+            imshow(windowName, edges);
+        }
+
+        int keyCode = waitKey(5);
+
+        if (keyCode == KeyCodes::ESC)
+        {
+            destroyWindow(windowName);
+            break;
+        }
+    }
+}
+
+void MainWindow::onCannyBtnClicked()
+{
+    loadCurrentImage();
+    cannyLow = 50;
+    cannyHigh = 150;
+    resetEdit();
+    string windowName = "Canny Edges";
+    namedWindow(windowName, WINDOW_AUTOSIZE);
+    Mat proxy = previewProxy(imageGrayed, previewSide);
+    imshow(windowName, proxy);
+
+    createTrackbar("Low", windowName, nullptr, 255, [](int value, void *userData)
+                   { cannyLow = value; }, nullptr);
+    setTrackbarPos("Low", windowName, cannyLow);
+    createTrackbar("High", windowName, nullptr, 255, [](int value, void *userData)
+                   { cannyHigh = value; }, nullptr);
+    setTrackbarPos("High", windowName, cannyHigh);
+
+    TrackbarWindowData userData;
+    userData.image = imageGrayed;
+    userData.windowName = windowName;
+    userData.mainWindow = this;
+    setMouseCallback(windowName, proxyPreviewMouseHandler, &userData);
+
+    int shownLow = -1, shownHigh = -1;
+
+    while (!didEditFinish)
+    {
+        if (cannyLow != shownLow || cannyHigh != shownHigh)
+        {
+            shownLow = cannyLow;
+            shownHigh = cannyHigh;
+            userData.operation = {OperationType::Canny, 0, {(double)min(shownLow, shownHigh), (double)max(shownLow, shownHigh)}};
+            imshow(windowName, applyOperation(proxy, userData.operation));
+        }
+
+        int keyCode = waitKey(5);
+
+        if (keyCode == KeyCodes::ESC)
+        {
+            destroyWindow(windowName);
+            break;
+        }
+    }
 }
 
 void MainWindow::onRedoBtnClicked()
 {
     currentImageIndex++;
-    images.at(currentImageIndex).copyTo(image);
     onImageProcessingSubmit(false);
 }
 
 void MainWindow::onShowDiffBtnPressed()
 {
-    ui->currentImageContainer->setPixmap(QPixmap::fromImage(matToQImage(images.at(0))));
+    showRevision(0);
 }
 
 void MainWindow::onShowDiffBtnReleased()
 {
-    ui->currentImageContainer->setPixmap(QPixmap::fromImage(matToQImage(images.at(currentImageIndex))));
+    showRevision(currentImageIndex);
 }
 
 void MainWindow::onUndoBtnClicked()
 {
     currentImageIndex--;
-    images.at(currentImageIndex).copyTo(image);
     onImageProcessingSubmit(false);
 }
 
@@ -1589,7 +2040,6 @@ void MainWindow::onResetBtnClicked()
 {
     resetEdit();
     currentImageIndex = 0;
-    images.at(0).copyTo(image);
-    images.erase(images.begin() + 1, images.end());
+    images.truncateAfter(0);
     onImageProcessingSubmit(false);
 }
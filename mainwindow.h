@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <opencv2/opencv.hpp>
+#include "image_operation.h"
+#include "image_processing.h"
 
 enum Categories
 {
@@ -30,8 +32,13 @@ public:
 
     void setupBtnFunctionalities();
     void enableBtnsOnUpload();
-    void onImageProcessingSubmit(bool shouldUpdateImages);
+    void onImageProcessingSubmit(bool shouldUpdateImages = true, const ImageOperation &operation = ImageOperation());
+    // Applies a point operation to the current image, composed with the previous ones in tone chain mode
+    void submitPointOperation(const ImageOperation &operation);
     void changeToolCategory(Categories category);
+    // Draws the part of revision index (currentImageIndex or the original, 0) selected by the view
+    // zoom and pan into currentImageContainer, compared with the original as compareModeBox selects
+    void showRevision(int index);
 
     // Popup options
     int showFlipPopup();
@@ -45,7 +52,8 @@ public:
     void onNegativeBtnClicked();
     void onLogTransformationBtnClicked();
     void onBitSlicingBtnClicked();
-    void onZoomBtnClicked();
+    // Crops the revision to the part shown in currentImageContainer
+    void onCropToViewBtnClicked();
     void onAreaOfInterestBtnClicked();
     void onDeSkewBtnClicked();
     void onSmoothingBtnClicked();
@@ -54,6 +62,9 @@ public:
     void onFrequencyDomainBtnClicked();
     void onSegmentationBtnClicked();
     void onLaplacianOfGaussianBtnClicked();
+    void onCannyBtnClicked();
+
+    void onToneChainBtnToggled(bool checked);
 
     void onUploadBtnClicked();
     void onSaveBtnClicked();
@@ -65,16 +76,15 @@ public:
     void onShowDiffBtnReleased();
     void onRedoBtnClicked();
 
-    cv::Mat traditionalKernel3x3 = (cv::Mat_<float>(3, 3) << 1, 1, 1, 1, 1, 1, 1, 1, 1) / 9;
-    cv::Mat pyramidalKernel5x5 = (cv::Mat_<float>(5, 5) << 1, 2, 3, 2, 1, 2, 4, 6, 4, 2, 3, 6, 9, 6, 3, 2, 4, 6, 4, 2, 1, 2, 3, 2, 1) / 81;
-    cv::Mat circularKernel5x5 = (cv::Mat_<float>(5, 5) << 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 0) / 21;
-    cv::Mat coneKernel5x5 = (cv::Mat_<float>(5, 5) << 0, 0, 1, 0, 0, 0, 2, 2, 2, 0, 1, 2, 5, 2, 1, 0, 2, 2, 2, 0, 0, 0, 1, 0, 0) / 25;
-    cv::Mat laplacianOfGaussianKernel = (cv::Mat_<float>(5, 5) << 0, 0, -1, 0, 0, 0, -1, -2, -1, 0, -1, -2, 16, -2, -1, 0, -1, -2, -1, 0, 0, 0, -1, 0, 0);
-
 private slots:
     void onImageContainerClicked();
+    void onImageContainerScrolled(QPoint position, double steps);
+    void onImageContainerDragged(QPoint offset);
 
 private:
+    // Applies the operations of a recipe file to the current image, one revision per operation
+    void applyRecipe(const QString &recipeName);
+
     Ui::MainWindow *ui;
 };
 #endif // MAINWINDOW_H
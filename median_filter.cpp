@@ -0,0 +1,147 @@
+#include "median_filter.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const int coarseBins = 16;
+static const int fineBins = 16;
+
+// Columns [x0, x1) of dst from padded, the plane with a border of radius on every side. Counts of
+// up to 101 x 101 pixels fit in 16 bits.
+static void filterStripe(const Mat &padded, Mat &dst, int radius, int x0, int x1)
+{
+    int diameter = 2 * radius + 1;
+    // the stripe and the radius columns on both sides of it
+    int columns = x1 - x0 + 2 * radius;
+    int rank = diameter * diameter / 2;
+
+    vector<uint16_t> fine((size_t)columns * 256), coarse((size_t)columns * coarseBins);
+    auto addRow = [&](const uchar *row, int delta)
+    {
+        for (int c = 0; c < columns; c++)
+        {
+            fine[c * 256 + row[c]] += delta;
+            coarse[c * coarseBins + (row[c] >> 4)] += delta;
+        }
+    };
+
+    for (int y = 0; y < diameter - 1; y++)
+    {
+        addRow(padded.ptr<uchar>(y) + x0, 1);
+    }
+
+    uint16_t kernelCoarse[coarseBins];
+    uint16_t kernelFine[coarseBins * fineBins];
+    // window start the fine bins of each coarse bin were last counted for, -1 when never
+    int fineStart[coarseBins];
+
+    for (int y = 0; y < dst.rows; y++)
+    {
+        if (y > 0)
+            addRow(padded.ptr<uchar>(y - 1) + x0, -1);
+        addRow(padded.ptr<uchar>(y + diameter - 1) + x0, 1);
+
+        fill(kernelCoarse, kernelCoarse + coarseBins, 0);
+        for (int c = 0; c < diameter; c++)
+        {
+            for (int b = 0; b < coarseBins; b++)
+            {
+                kernelCoarse[b] += coarse[c * coarseBins + b];
+            }
+        }
+        fill(fineStart, fineStart + coarseBins, -1);
+
+        uchar *dstRow = dst.ptr<uchar>(y) + x0;
+        for (int x = 0; x < x1 - x0; x++)
+        {
+            if (x > 0)
+            {
+                const uint16_t *entering = &coarse[(x + diameter - 1) * coarseBins];
+                const uint16_t *leaving = &coarse[(x - 1) * coarseBins];
+                for (int b = 0; b < coarseBins; b++)
+                {
+                    kernelCoarse[b] += entering[b] - leaving[b];
+                }
+            }
+
+            int b = 0;
+            int count = 0;
+            while (count + kernelCoarse[b] <= rank)
+            {
+                count += kernelCoarse[b];
+                b++;
+            }
+
+            // catching up costs two columns per step, counting afresh costs the whole window
+            uint16_t *segment = kernelFine + b * fineBins;
+            if (fineStart[b] < 0 || x - fineStart[b] >= diameter)
+            {
+                fill(segment, segment + fineBins, 0);
+                for (int c = x; c < x + diameter; c++)
+                {
+                    const uint16_t *column = &fine[c * 256 + b * fineBins];
+                    for (int v = 0; v < fineBins; v++)
+                    {
+                        segment[v] += column[v];
+                    }
+                }
+            }
+            else
+            {
+                for (int c = fineStart[b]; c < x; c++)
+                {
+                    const uint16_t *entering = &fine[(c + diameter) * 256 + b * fineBins];
+                    const uint16_t *leaving = &fine[c * 256 + b * fineBins];
+                    for (int v = 0; v < fineBins; v++)
+                    {
+                        segment[v] += entering[v] - leaving[v];
+                    }
+                }
+            }
+            fineStart[b] = x;
+
+            int v = 0;
+            while (count + segment[v] <= rank)
+            {
+                count += segment[v];
+                v++;
+            }
+            dstRow[x] = (uchar)(b * fineBins + v);
+        }
+    }
+}
+
+Mat constantTimeMedian(const Mat &image, int radius)
+{
+    CV_Assert(image.depth() == CV_8U && radius >= 1 && radius <= 50);
+
+    vector<Mat> planes;
+    split(image, planes);
+    vector<Mat> padded(planes.size()), filtered(planes.size());
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        copyMakeBorder(planes[i], padded[i], radius, radius, radius, radius, BORDER_REPLICATE);
+        filtered[i].create(planes[i].size(), CV_8UC1);
+    }
+
+    // every stripe counts its own halo columns, so stripes are kept a few windows wide
+    int diameter = 2 * radius + 1;
+    int stripes = max(1, min(image.cols / max(4 * diameter, 64), getNumThreads()));
+    int planeCount = (int)planes.size();
+
+    parallel_for_(Range(0, planeCount * stripes), [&](const Range &range)
+                  {
+        for (int task = range.start; task < range.end; task++)
+        {
+            int plane = task / stripes;
+            int stripe = task % stripes;
+            filterStripe(padded[plane], filtered[plane], radius, image.cols * stripe / stripes, image.cols * (stripe + 1) / stripes);
+        } });
+
+    Mat dstImage;
+    merge(filtered, dstImage);
+    return dstImage;
+}
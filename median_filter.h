@@ -0,0 +1,13 @@
+#ifndef MEDIAN_FILTER_H
+#define MEDIAN_FILTER_H
+
+#include <opencv2/opencv.hpp>
+
+// Median over a (2 * radius + 1) square of every channel of an 8 bit image, with the cost of a
+// pixel independent of the radius (Perreault and Hebert): a 256 bin histogram per column slides
+// down one row at a time, and the window histogram slides along the row from those columns in 16
+// coarse bins, the 16 fine bins of a coarse bin are only brought up to date when the median falls
+// in it. Vertical stripes of every channel run in parallel. Borders are replicated like medianBlur.
+cv::Mat constantTimeMedian(const cv::Mat &image, int radius);
+
+#endif // MEDIAN_FILTER_H
@@ -0,0 +1,246 @@
+#include "point_lut.h"
+#include <cfloat>
+#include <cmath>
+#include <mutex>
+
+using namespace cv;
+using namespace std;
+
+vector<vector<long long>> channelHistograms(const Mat &image)
+{
+    CV_Assert(image.depth() == CV_8U);
+
+    int channels = image.channels();
+    vector<vector<long long>> histograms(channels, vector<long long>(256, 0));
+    mutex histogramsMutex;
+
+    parallel_for_(Range(0, image.rows), [&](const Range &rows)
+                  {
+        // Each stripe counts into its own bins, split in two interleaved sets so runs of equal
+        // pixels don't serialize on the same counter, and merges them once at the end
+        vector<long long> bins(2 * channels * 256, 0);
+        long long *even = bins.data();
+        long long *odd = bins.data() + channels * 256;
+        int rowLength = image.cols * channels;
+
+        for (int i = rows.start; i < rows.end; i++)
+        {
+            const uchar *row = image.ptr<uchar>(i);
+            int j = 0;
+            for (; j + 2 * channels <= rowLength; j += 2 * channels)
+            {
+                for (int c = 0; c < channels; c++)
+                {
+                    even[c * 256 + row[j + c]]++;
+                    odd[c * 256 + row[j + channels + c]]++;
+                }
+            }
+            for (; j < rowLength; j += channels)
+            {
+                for (int c = 0; c < channels; c++)
+                {
+                    even[c * 256 + row[j + c]]++;
+                }
+            }
+        }
+
+        lock_guard<mutex> lock(histogramsMutex);
+        for (int c = 0; c < channels; c++)
+        {
+            for (int value = 0; value < 256; value++)
+            {
+                histograms[c][value] += even[c * 256 + value] + odd[c * 256 + value];
+            }
+        } });
+
+    return histograms;
+}
+
+vector<long long> grayHistogram(const Mat &gray)
+{
+    CV_Assert(gray.type() == CV_8UC1);
+    return channelHistograms(gray)[0];
+}
+
+vector<long long> remapHistogram(const vector<long long> &histogram, const Mat &lut)
+{
+    vector<long long> remapped(256, 0);
+    for (int value = 0; value < 256; value++)
+    {
+        remapped[lut.at<uchar>(value)] += histogram[value];
+    }
+    return remapped;
+}
+
+int histogramMean(const vector<long long> &histogram)
+{
+    long long total = 0;
+    long long pixelValues = 0;
+    for (int value = 0; value < 256; value++)
+    {
+        total += histogram[value];
+        pixelValues += histogram[value] * value;
+    }
+    return total > 0 ? pixelValues / total : 0;
+}
+
+// Stretches curve to [0, 255] over the gray levels present in the image, the same scale and
+// shift normalize(NORM_MINMAX) followed by convertScaleAbs would apply to the float image
+static Mat normalizedLut(const float curve[256], const vector<long long> &histogram)
+{
+    double minValue = DBL_MAX;
+    double maxValue = -DBL_MAX;
+    for (int value = 0; value < 256; value++)
+    {
+        if (histogram[value] > 0)
+        {
+            minValue = min(minValue, (double)curve[value]);
+            maxValue = max(maxValue, (double)curve[value]);
+        }
+    }
+    if (minValue > maxValue)
+        minValue = maxValue = 0;
+
+    double scale = maxValue - minValue > DBL_EPSILON ? 255.0 / (maxValue - minValue) : 0;
+    double shift = -minValue * scale;
+
+    Mat lut(1, 256, CV_8U);
+    for (int value = 0; value < 256; value++)
+    {
+        lut.at<uchar>(value) = saturate_cast<uchar>(fabs((float)(curve[value] * scale + shift)));
+    }
+    return lut;
+}
+
+Mat identityLut()
+{
+    Mat lut(1, 256, CV_8U);
+    for (int value = 0; value < 256; value++)
+    {
+        lut.at<uchar>(value) = value;
+    }
+    return lut;
+}
+
+Mat negativeLut()
+{
+    Mat lut(1, 256, CV_8U);
+    for (int value = 0; value < 256; value++)
+    {
+        lut.at<uchar>(value) = 255 - value;
+    }
+    return lut;
+}
+
+Mat bitSlicingLut()
+{
+    Mat lut(1, 256, CV_8U);
+    for (int value = 0; value < 256; value++)
+    {
+        lut.at<uchar>(value) = value & 128 ? 255 : 0;
+    }
+    return lut;
+}
+
+Mat thresholdLut(int t0)
+{
+    Mat lut(1, 256, CV_8U);
+    for (int value = 0; value < 256; value++)
+    {
+        lut.at<uchar>(value) = value > t0 ? 255 : 0;
+    }
+    return lut;
+}
+
+Mat grayLevelSlicingLut(int rangeFrom, int rangeTo, bool keepOutside)
+{
+    Mat lut(1, 256, CV_8U);
+    for (int value = 0; value < 256; value++)
+    {
+        lut.at<uchar>(value) = value > rangeFrom && value < rangeTo ? 255 : keepOutside ? value
+                                                                                        : 0;
+    }
+    return lut;
+}
+
+Mat logLut(const vector<long long> &histogram)
+{
+    float curve[256];
+    for (int value = 0; value < 256; value++)
+    {
+        curve[value] = log(value + 1);
+    }
+    return normalizedLut(curve, histogram);
+}
+
+Mat gammaLut(float gamma, const vector<long long> &histogram)
+{
+    float curve[256];
+    for (int value = 0; value < 256; value++)
+    {
+        curve[value] = pow((float)value, gamma);
+    }
+    return normalizedLut(curve, histogram);
+}
+
+Mat equalizeLut(const vector<long long> &histogram)
+{
+    Mat lut = Mat::zeros(1, 256, CV_8U);
+
+    long long total = 0;
+    for (int value = 0; value < 256; value++)
+    {
+        total += histogram[value];
+    }
+
+    int first = 0;
+    while (first < 255 && histogram[first] == 0)
+        first++;
+
+    // a single gray level is left as it is
+    if (histogram[first] == total)
+    {
+        lut.setTo(first);
+        return lut;
+    }
+
+    float scale = 255.f / (total - histogram[first]);
+    long long sum = 0;
+    for (int value = first + 1; value < 256; value++)
+    {
+        sum += histogram[value];
+        lut.at<uchar>(value) = saturate_cast<uchar>(sum * scale);
+    }
+    return lut;
+}
+
+Mat composeLuts(const Mat &first, const Mat &second)
+{
+    Mat lut;
+    LUT(first, second, lut);
+    return lut;
+}
+
+Mat applyLut(const Mat &gray, const Mat &lut)
+{
+    Mat dstImage;
+    LUT(gray, lut, dstImage);
+    return dstImage;
+}
+
+Mat lutCurveImage(const Mat &lut, int size)
+{
+    Mat curveImage(size, size, CV_8UC3, Scalar(255, 255, 255));
+    double scale = (size - 1) / 255.0;
+
+    line(curveImage, Point(0, size - 1), Point(size - 1, 0), Scalar(200, 200, 200));
+
+    vector<Point> points;
+    for (int value = 0; value < 256; value++)
+    {
+        points.push_back(Point(cvRound(value * scale), size - 1 - cvRound(lut.at<uchar>(value) * scale)));
+    }
+    polylines(curveImage, points, false, Scalar(0, 0, 0), 1, LINE_AA);
+
+    return curveImage;
+}
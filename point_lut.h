@@ -0,0 +1,41 @@
+#ifndef POINT_LUT_H
+#define POINT_LUT_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Point operations on 8 bit gray images as 256 entry lookup tables (1x256 CV_8UC1), built once per
+// parameter and applied with cv::LUT in a single byte to byte pass.
+//
+// Operations that normalize their output (log, gamma, equalize) take the histogram of their
+// input: the output of a point operation only depends on which gray levels are present, so
+// min/max and the cumulative distribution come from the 256 counts instead of a float image.
+
+// 256 counts per channel of an 8 bit image, counted in parallel row stripes with 64 bit bins
+std::vector<std::vector<long long>> channelHistograms(const cv::Mat &image);
+// 256 counts of the gray levels of an 8 bit single channel image
+std::vector<long long> grayHistogram(const cv::Mat &gray);
+// Histogram of the image after applying lut, without touching the pixels
+std::vector<long long> remapHistogram(const std::vector<long long> &histogram, const cv::Mat &lut);
+// Average gray level, the automatic segmentation threshold
+int histogramMean(const std::vector<long long> &histogram);
+
+cv::Mat identityLut();
+cv::Mat negativeLut();
+cv::Mat bitSlicingLut();
+cv::Mat thresholdLut(int t0);
+// 255 for from < value < to, 0 (or value when keepOutside) otherwise
+cv::Mat grayLevelSlicingLut(int rangeFrom, int rangeTo, bool keepOutside = false);
+cv::Mat logLut(const std::vector<long long> &histogram);
+cv::Mat gammaLut(float gamma, const std::vector<long long> &histogram);
+// Same table cv::equalizeHist builds
+cv::Mat equalizeLut(const std::vector<long long> &histogram);
+
+// Table of second(first(value))
+cv::Mat composeLuts(const cv::Mat &first, const cv::Mat &second);
+cv::Mat applyLut(const cv::Mat &gray, const cv::Mat &lut);
+
+// size x size plot of the table, input on the x axis, with the identity as reference
+cv::Mat lutCurveImage(const cv::Mat &lut, int size = 256);
+
+#endif // POINT_LUT_H
@@ -0,0 +1,184 @@
+#include "recipe.h"
+#include "image_processing.h"
+#include <fstream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+static string trim(const string &text)
+{
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == string::npos)
+        return "";
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+bool parseRecipe(const string &text, vector<ImageOperation> &operations, string &error)
+{
+    stringstream stream(text);
+    string line;
+    int lineNumber = 0;
+
+    while (getline(stream, line))
+    {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        size_t start = 0;
+        while (start <= line.size())
+        {
+            size_t arrow = line.find("->", start);
+            string step = trim(line.substr(start, arrow == string::npos ? string::npos : arrow - start));
+
+            if (!step.empty())
+            {
+                ImageOperation operation;
+                string operationError;
+                if (!parseOperation(step, operation, operationError))
+                {
+                    error = "line " + to_string(lineNumber) + ": " + operationError;
+                    return false;
+                }
+                operations.push_back(operation);
+            }
+
+            if (arrow == string::npos)
+                break;
+            start = arrow + 2;
+        }
+    }
+
+    return true;
+}
+
+bool loadRecipe(const string &path, vector<ImageOperation> &operations, string &error)
+{
+    ifstream file(path);
+    if (!file)
+    {
+        error = "failed to open " + path;
+        return false;
+    }
+
+    stringstream text;
+    text << file.rdbuf();
+    return parseRecipe(text.str(), operations, error);
+}
+
+bool saveRecipe(const string &path, const vector<ImageOperation> &operations, string &error)
+{
+    for (const ImageOperation &operation : operations)
+    {
+        if (!isReplayable(operation))
+        {
+            error = "the session contains edits that can't be replayed";
+            return false;
+        }
+    }
+
+    ofstream file(path);
+    if (!file)
+    {
+        error = "failed to write " + path;
+        return false;
+    }
+
+    file << "# image-processing recipe" << endl;
+    for (const ImageOperation &operation : operations)
+    {
+        file << formatOperation(operation) << endl;
+    }
+
+    return true;
+}
+
+vector<RecipeStage> planRecipe(const vector<ImageOperation> &operations)
+{
+    vector<RecipeStage> plan;
+
+    for (const ImageOperation &operation : operations)
+    {
+        if (isPointOperation(operation))
+        {
+            if (!plan.empty() && plan.back().kind == RecipeStageKind::PointLookup)
+                plan.back().operations.push_back(operation);
+            else
+                plan.push_back({RecipeStageKind::PointLookup, {operation}});
+            continue;
+        }
+
+        if (isGeometryOperation(operation))
+        {
+            int target = (int)plan.size() - 1;
+
+            // a flip only moves pixels, it can run before the point operations that precede it
+            if (operation.type == OperationType::Flip)
+            {
+                while (target >= 0 && plan[target].kind == RecipeStageKind::PointLookup)
+                    target--;
+            }
+
+            if (target >= 0 && plan[target].kind == RecipeStageKind::Geometry)
+                plan[target].operations.push_back(operation);
+            else
+                plan.push_back({RecipeStageKind::Geometry, {operation}});
+            continue;
+        }
+
+        plan.push_back({RecipeStageKind::Operation, {operation}});
+    }
+
+    return plan;
+}
+
+string describePlan(const vector<RecipeStage> &plan)
+{
+    string description;
+
+    for (size_t i = 0; i < plan.size(); i++)
+    {
+        const RecipeStage &stage = plan[i];
+        description += to_string(i + 1) + ". ";
+        if (stage.kind == RecipeStageKind::PointLookup)
+            description += "lookup table: ";
+        else if (stage.kind == RecipeStageKind::Geometry)
+            description += "single warp: ";
+
+        for (size_t j = 0; j < stage.operations.size(); j++)
+        {
+            description += (j ? " -> " : "") + formatOperation(stage.operations[j]);
+        }
+        description += "\n";
+    }
+
+    return description;
+}
+
+Mat executePlan(const Mat &image, const vector<RecipeStage> &plan)
+{
+    Mat dstImage = image;
+
+    for (const RecipeStage &stage : plan)
+    {
+        switch (stage.kind)
+        {
+        case RecipeStageKind::PointLookup:
+            dstImage = applyPointOperations(dstImage, stage.operations);
+            break;
+        case RecipeStageKind::Geometry:
+            dstImage = applyGeometryOperations(dstImage, stage.operations);
+            break;
+        case RecipeStageKind::Operation:
+        default:
+            dstImage = applyOperation(dstImage, stage.operations.at(0));
+            break;
+        }
+    }
+
+    if (dstImage.data == image.data)
+        dstImage = image.clone();
+
+    return dstImage;
+}
@@ -0,0 +1,36 @@
+#ifndef RECIPE_H
+#define RECIPE_H
+
+#include "image_operation.h"
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+enum class RecipeStageKind
+{
+    // a single operation run through applyOperation
+    Operation,
+    // consecutive gray level point operations folded into one lookup table pass
+    PointLookup,
+    // consecutive flips and affine warps resampled once
+    Geometry
+};
+
+struct RecipeStage
+{
+    RecipeStageKind kind = RecipeStageKind::Operation;
+    std::vector<ImageOperation> operations;
+};
+
+// One operation per line or "grayscale -> median3 -> sobel(both) -> threshold(t0=80)", # starts a comment
+bool loadRecipe(const std::string &path, std::vector<ImageOperation> &operations, std::string &error);
+bool saveRecipe(const std::string &path, const std::vector<ImageOperation> &operations, std::string &error);
+bool parseRecipe(const std::string &text, std::vector<ImageOperation> &operations, std::string &error);
+
+// Groups the operations into stages that touch the image once. Flips commute with point operations
+// and move back to the previous geometry stage, affine warps only merge with an adjacent one.
+std::vector<RecipeStage> planRecipe(const std::vector<ImageOperation> &operations);
+std::string describePlan(const std::vector<RecipeStage> &plan);
+cv::Mat executePlan(const cv::Mat &image, const std::vector<RecipeStage> &plan);
+
+#endif // RECIPE_H
@@ -0,0 +1,118 @@
+#include "scale_space.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+// Octaves stop once the short side would drop below this
+static const int minimumOctaveSide = 8;
+// Sigma, in pixels of an octave, above which the next octave has enough resolution
+static const double octaveSigma = 2;
+// Ratio of the two Gaussians of a difference of Gaussians, close to the Laplacian for 1.6
+static const double differenceRatio = 1.6;
+
+ScaleSpace::ScaleSpace(const Mat &gray)
+{
+    CV_Assert(gray.channels() == 1);
+
+    Mat base;
+    gray.convertTo(base, CV_32F);
+    octaves.push_back(base);
+    octaveBlur.push_back(0);
+
+    // pyrDown smooths with [1 4 6 4 1] / 16, a sigma of 1, before dropping every other pixel
+    while (min(octaves.back().cols, octaves.back().rows) / 2 >= minimumOctaveSide)
+    {
+        Mat next;
+        pyrDown(octaves.back(), next);
+        octaves.push_back(next);
+        octaveBlur.push_back(sqrt(octaveBlur.back() * octaveBlur.back() + 1) / 2);
+    }
+}
+
+bool ScaleSpace::empty() const
+{
+    return octaves.empty();
+}
+
+Mat ScaleSpace::laplacian(double sigma) const
+{
+    CV_Assert(!empty() && sigma > 0);
+
+    int octave = 0;
+    while (octave + 1 < (int)octaves.size() && sigma / (2 << octave) >= octaveSigma)
+    {
+        octave++;
+    }
+
+    Mat response;
+    if (octave == 0)
+    {
+        Mat smoothed;
+        GaussianBlur(octaves[0], smoothed, Size(), sigma, sigma, BORDER_REFLECT_101);
+        Laplacian(smoothed, response, CV_32F, 1, sigma * sigma, 0, BORDER_REFLECT_101);
+        return response;
+    }
+
+    // G(s * sqrt(k)) - G(s / sqrt(k)) is about s (k - 1) / sqrt(k) dG/ds = (k - 1) / sqrt(k) s^2 Laplacian
+    double scale = 1 << octave;
+    double local = sigma / scale;
+    double blur = octaveBlur[octave];
+    Mat inner, outer;
+    GaussianBlur(octaves[octave], inner, Size(), sqrt(local * local / differenceRatio - blur * blur), 0, BORDER_REFLECT_101);
+    GaussianBlur(octaves[octave], outer, Size(), sqrt(local * local * differenceRatio - blur * blur), 0, BORDER_REFLECT_101);
+    Mat difference = (outer - inner) * (sqrt(differenceRatio) / (differenceRatio - 1));
+
+    // pixel i of an octave is pixel i * scale of the full plane
+    Matx23d toOctave(1 / scale, 0, 0, 0, 1 / scale, 0);
+    warpAffine(difference, response, toOctave, octaves[0].size(), INTER_LINEAR | WARP_INVERSE_MAP, BORDER_REPLICATE);
+    return response;
+}
+
+Mat zeroCrossings(const Mat &laplacian, double sigma, double contrast)
+{
+    CV_Assert(laplacian.type() == CV_32FC1);
+
+    // across the zero crossing of a step of h the response changes by h / (sigma sqrt(2 pi)) a pixel
+    float minimumChange = (float)(contrast / (sigma * sqrt(2 * CV_PI)));
+    Mat edges(laplacian.size(), CV_8UC1);
+
+    parallel_for_(Range(0, laplacian.rows), [&](const Range &rows)
+                  {
+        for (int y = rows.start; y < rows.end; y++)
+        {
+            const float *row = laplacian.ptr<float>(y);
+            const float *above = y > 0 ? laplacian.ptr<float>(y - 1) : nullptr;
+            const float *below = y + 1 < laplacian.rows ? laplacian.ptr<float>(y + 1) : nullptr;
+            uchar *edgeRow = edges.ptr<uchar>(y);
+
+            for (int x = 0; x < laplacian.cols; x++)
+            {
+                float value = row[x];
+                // only the pixel closer to zero is marked, so the edge is one pixel wide
+                auto crosses = [&](float neighbour)
+                {
+                    return (value < 0) != (neighbour < 0) && fabs(value) <= fabs(neighbour) && fabs(value - neighbour) >= minimumChange;
+                };
+
+                bool isEdge = (x > 0 && crosses(row[x - 1])) || (x + 1 < laplacian.cols && crosses(row[x + 1])) ||
+                              (above && crosses(above[x])) || (below && crosses(below[x]));
+                edgeRow[x] = isEdge ? 255 : 0;
+            }
+        } });
+
+    return edges;
+}
+
+Mat laplacianEdges(const Mat &gray, const vector<double> &sigmas, double contrast)
+{
+    ScaleSpace scaleSpace(gray);
+    Mat edges = Mat::zeros(gray.size(), CV_8UC1);
+
+    for (double sigma : sigmas)
+    {
+        bitwise_or(edges, zeroCrossings(scaleSpace.laplacian(sigma), sigma, contrast), edges);
+    }
+    return edges;
+}
@@ -0,0 +1,37 @@
+#ifndef SCALE_SPACE_H
+#define SCALE_SPACE_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Laplacian of Gaussian of one gray plane at any scale from a Gaussian pyramid built once.
+//
+// Small sigmas are a separable Gaussian pass and a 3x3 Laplacian at full resolution. Larger ones
+// run on the octave where sigma is 2 to 4 pixels, as a difference of two Gaussians, and the result
+// is scaled back up: every scale costs about the same whatever its sigma.
+class ScaleSpace
+{
+public:
+    ScaleSpace() = default;
+    explicit ScaleSpace(const cv::Mat &gray);
+
+    bool empty() const;
+    // Scale normalized sigma^2 * Laplacian, CV_32FC1 of the size of the gray plane. Signed,
+    // positive on the dark side of an edge; a step of h gray levels peaks at about h / 4.
+    cv::Mat laplacian(double sigma) const;
+
+private:
+    // CV_32FC1, each half the size of the previous one
+    std::vector<cv::Mat> octaves;
+    // blur already in every octave, in pixels of that octave
+    std::vector<double> octaveBlur;
+};
+
+// Zero crossings of a laplacian at sigma, 255 on the pixel of a sign change closer to zero.
+// contrast: smallest step, in gray levels, that gives an edge
+cv::Mat zeroCrossings(const cv::Mat &laplacian, double sigma, double contrast);
+
+// Union of the zero crossings at every sigma, all computed from the same pyramid
+cv::Mat laplacianEdges(const cv::Mat &gray, const std::vector<double> &sigmas, double contrast);
+
+#endif // SCALE_SPACE_H
@@ -0,0 +1,249 @@
+#include "smoothing_filter.h"
+#include "fixed_kernels.h"
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+using namespace cv;
+using namespace std;
+
+// largest divisor tried when recovering the integer weights of a float kernel
+static const int maxDivisor = 1024;
+
+// round(value / divisor) computed as (value + half) * multiplier >> shift, so the rows are divided
+// with a 32 bit multiply the compiler can vectorize instead of an integer division per pixel
+struct ExactDivision
+{
+    uint32_t half = 0;
+    uint32_t multiplier = 1;
+    int shift = 0;
+};
+
+// With multiplier = ceil(2^shift / divisor) and error = multiplier * divisor - 2^shift, the
+// quotient is exact for every value with value * error < 2^shift
+static bool exactDivision(int divisor, uint32_t maxValue, ExactDivision &division)
+{
+    division.half = divisor / 2;
+    uint64_t largest = (uint64_t)maxValue + division.half;
+
+    for (int shift = 31; shift >= 0; shift--)
+    {
+        uint64_t multiplier = ((1ull << shift) + divisor - 1) / divisor;
+        uint64_t error = multiplier * divisor - (1ull << shift);
+        if (largest * multiplier <= UINT32_MAX && largest * error < (1ull << shift))
+        {
+            division.multiplier = (uint32_t)multiplier;
+            division.shift = shift;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int gcdOf(const vector<int> &values)
+{
+    int divisor = 0;
+    for (int value : values)
+    {
+        divisor = gcd(divisor, value);
+    }
+    return max(1, divisor);
+}
+
+// weights = scale * column x row exactly, or nothing
+static void factorize(IntegerKernel &integerKernel)
+{
+    const Mat &weights = integerKernel.weights;
+
+    Point pivot;
+    minMaxLoc(weights, nullptr, nullptr, nullptr, &pivot);
+    long long pivotWeight = weights.at<int>(pivot);
+
+    for (int i = 0; i < weights.rows; i++)
+    {
+        for (int j = 0; j < weights.cols; j++)
+        {
+            if ((long long)weights.at<int>(i, j) * pivotWeight != (long long)weights.at<int>(i, pivot.x) * weights.at<int>(pivot.y, j))
+                return;
+        }
+    }
+
+    vector<int> column(weights.rows), row(weights.cols);
+    for (int i = 0; i < weights.rows; i++)
+    {
+        column[i] = weights.at<int>(i, pivot.x);
+    }
+    for (int j = 0; j < weights.cols; j++)
+    {
+        row[j] = weights.at<int>(pivot.y, j);
+    }
+
+    // column x row = pivotWeight * weights, dividing both by their gcd leaves the smallest factors
+    long long columnGcd = gcdOf(column);
+    long long rowGcd = gcdOf(row);
+    if ((columnGcd * rowGcd) % pivotWeight != 0)
+        return;
+
+    for (int &weight : column)
+    {
+        weight /= columnGcd;
+    }
+    for (int &weight : row)
+    {
+        weight /= rowGcd;
+    }
+    integerKernel.column = column;
+    integerKernel.row = row;
+    integerKernel.scale = (int)(columnGcd * rowGcd / pivotWeight);
+}
+
+bool integerKernelOf(const Mat &kernel, IntegerKernel &integerKernel)
+{
+    if (kernel.empty() || kernel.channels() != 1 || kernel.rows % 2 == 0 || kernel.cols % 2 == 0)
+        return false;
+
+    Mat weights;
+    kernel.convertTo(weights, CV_64F);
+
+    double minWeight;
+    minMaxLoc(weights, &minWeight);
+    if (minWeight < 0)
+        return false;
+
+    for (int divisor = 1; divisor <= maxDivisor; divisor++)
+    {
+        Mat integers(weights.size(), CV_32S);
+        bool isInteger = true;
+        long long sum = 0;
+
+        for (int i = 0; i < weights.rows && isInteger; i++)
+        {
+            for (int j = 0; j < weights.cols && isInteger; j++)
+            {
+                double value = weights.at<double>(i, j) * divisor;
+                long long rounded = llround(value);
+                isInteger = fabs(value - rounded) < 1e-3;
+                integers.at<int>(i, j) = (int)rounded;
+                sum += rounded;
+            }
+        }
+
+        if (!isInteger)
+            continue;
+        if (sum == 0 || sum * 255 > UINT16_MAX)
+            return false;
+
+        integerKernel = IntegerKernel();
+        integerKernel.weights = integers;
+        integerKernel.divisor = divisor;
+        factorize(integerKernel);
+        return true;
+    }
+
+    return false;
+}
+
+static void divideRow(const uint16_t *sums, uchar *dst, int length, uint32_t scale, const ExactDivision &division)
+{
+    for (int x = 0; x < length; x++)
+    {
+        uint32_t value = ((uint32_t)sums[x] * scale + division.half) * division.multiplier >> division.shift;
+        dst[x] = (uchar)min(value, 255u);
+    }
+}
+
+// One tap of a row: sums[x] += weight * src[x], 16 bit lanes
+static void accumulateRow(uint16_t *sums, const uchar *src, int length, uint16_t weight)
+{
+    for (int x = 0; x < length; x++)
+    {
+        sums[x] = (uint16_t)(sums[x] + weight * src[x]);
+    }
+}
+
+static void accumulateRow(uint16_t *sums, const uint16_t *src, int length, uint16_t weight)
+{
+    for (int x = 0; x < length; x++)
+    {
+        sums[x] = (uint16_t)(sums[x] + weight * src[x]);
+    }
+}
+
+void smoothingFilter(const Mat &src, Mat &dst, const Mat &kernel)
+{
+    IntegerKernel integerKernel;
+    bool isInteger = src.depth() == CV_8U && !src.empty() && integerKernelOf(kernel, integerKernel);
+
+    // two 1-D passes take fewer taps than any 2-D kernel, the other fixed kernels are fastest unrolled
+    if ((!isInteger || integerKernel.row.empty()) && fixedKernelFilter(src, dst, kernel))
+        return;
+
+    ExactDivision division;
+    if (!isInteger || !exactDivision(integerKernel.divisor, (uint32_t)sum(integerKernel.weights)[0] * 255, division))
+    {
+        filter2D(src, dst, -1, kernel);
+        return;
+    }
+
+    int radiusY = kernel.rows / 2;
+    int radiusX = kernel.cols / 2;
+    int channels = src.channels();
+    int length = src.cols * channels;
+
+    // a submatrix takes its border from the parent image, like filter2D
+    Mat padded;
+    copyMakeBorder(src, padded, radiusY, radiusY, radiusX, radiusX, BORDER_REFLECT_101);
+    dst.create(src.size(), src.type());
+
+    const IntegerKernel &weights = integerKernel;
+    bool isSeparable = !weights.row.empty();
+
+    parallel_for_(Range(0, src.rows), [&](const Range &rows)
+                  {
+        vector<uint16_t> sums(length);
+
+        if (!isSeparable)
+        {
+            for (int y = rows.start; y < rows.end; y++)
+            {
+                fill(sums.begin(), sums.end(), 0);
+                for (int i = 0; i < kernel.rows; i++)
+                {
+                    const uchar *row = padded.ptr<uchar>(y + i);
+                    for (int j = 0; j < kernel.cols; j++)
+                    {
+                        int weight = weights.weights.at<int>(i, j);
+                        if (weight != 0)
+                            accumulateRow(sums.data(), row + j * channels, length, (uint16_t)weight);
+                    }
+                }
+                divideRow(sums.data(), dst.ptr<uchar>(y), length, 1, division);
+            }
+            return;
+        }
+
+        // horizontal pass over the rows of the stripe and its halo, then the vertical pass
+        int stripeRows = rows.size() + 2 * radiusY;
+        vector<uint16_t> horizontal((size_t)stripeRows * length, 0);
+        for (int r = 0; r < stripeRows; r++)
+        {
+            const uchar *row = padded.ptr<uchar>(rows.start + r);
+            uint16_t *rowSums = &horizontal[(size_t)r * length];
+            for (int j = 0; j < kernel.cols; j++)
+            {
+                if (weights.row[j] != 0)
+                    accumulateRow(rowSums, row + j * channels, length, (uint16_t)weights.row[j]);
+            }
+        }
+
+        for (int y = rows.start; y < rows.end; y++)
+        {
+            fill(sums.begin(), sums.end(), 0);
+            for (int i = 0; i < kernel.rows; i++)
+            {
+                if (weights.column[i] != 0)
+                    accumulateRow(sums.data(), &horizontal[(size_t)(y - rows.start + i) * length], length, (uint16_t)weights.column[i]);
+            }
+            divideRow(sums.data(), dst.ptr<uchar>(y), length, weights.scale, division);
+        } });
+}
@@ -0,0 +1,34 @@
+#ifndef SMOOTHING_FILTER_H
+#define SMOOTHING_FILTER_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 8 bit smoothing in integer arithmetic. The built-in smoothing kernels are small non negative
+// integer weights over a divisor (1/9, 1/81, 1/21, 1/25), they run with 16 bit accumulators and an
+// exactly rounded division by the divisor. Kernels that are the outer product of a column and a row
+// (traditional, pyramidal) run as two 1-D passes, the other fixed kernels (circular, cone) through
+// their compile time convolution (see fixed_kernels.h). Any other kernel or depth goes to
+// cv::filter2D.
+
+struct IntegerKernel
+{
+    // weights / divisor is the kernel, CV_32SC1
+    cv::Mat weights;
+    int divisor = 1;
+    // weights = scale * column x row when the kernel is separable, both empty otherwise
+    std::vector<int> column;
+    std::vector<int> row;
+    int scale = 1;
+};
+
+// false when the kernel isn't odd sized, or isn't made of non negative integer weights over a
+// divisor whose sum times 255 fits a 16 bit accumulator
+bool integerKernelOf(const cv::Mat &kernel, IntegerKernel &integerKernel);
+
+// filter2D(src, dst, -1, kernel) with the default BORDER_REFLECT_101, the result is the rounded
+// exact weighted sum where filter2D rounds the float one. A submatrix reads its border from the
+// pixels of the parent image, as filter2D does.
+void smoothingFilter(const cv::Mat &src, cv::Mat &dst, const cv::Mat &kernel);
+
+#endif // SMOOTHING_FILTER_H
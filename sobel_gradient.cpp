@@ -0,0 +1,108 @@
+#include "sobel_gradient.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// The 5x5 Sobel kernels are [1 4 6 4 1] smoothing across the derivative [-1 -2 0 2 1]. Sums of 8
+// bit pixels stay within +-16 * 6 * 255 = +-24480, signed 16 bit holds every intermediate.
+// Every output is optional.
+static void sobelSweep(const Mat &gray, Mat *magnitude, GradientNorm norm, Mat *orientation, int orientationBins, Mat *dx, Mat *dy)
+{
+    CV_Assert(gray.type() == CV_8UC1 && orientationBins > 0);
+
+    // same border as cv::Sobel
+    Mat padded;
+    copyMakeBorder(gray, padded, 2, 2, 2, 2, BORDER_REFLECT_101);
+
+    if (magnitude)
+        magnitude->create(gray.size(), CV_8UC1);
+    if (orientation)
+        orientation->create(gray.size(), CV_8UC1);
+    if (dx)
+        dx->create(gray.size(), CV_16SC1);
+    if (dy)
+        dy->create(gray.size(), CV_16SC1);
+
+    int width = gray.cols;
+
+    parallel_for_(Range(0, gray.rows), [&](const Range &rows)
+                  {
+        // vertical smoothing and derivative of the 5 rows around the output row, border columns included
+        vector<int16_t> smoothed(width + 4), derivative(width + 4);
+        vector<int16_t> gradientX(width), gradientY(width);
+
+        for (int y = rows.start; y < rows.end; y++)
+        {
+            const uchar *p0 = padded.ptr<uchar>(y);
+            const uchar *p1 = padded.ptr<uchar>(y + 1);
+            const uchar *p2 = padded.ptr<uchar>(y + 2);
+            const uchar *p3 = padded.ptr<uchar>(y + 3);
+            const uchar *p4 = padded.ptr<uchar>(y + 4);
+
+            for (int x = 0; x < width + 4; x++)
+            {
+                smoothed[x] = (int16_t)(p0[x] + 4 * (p1[x] + p3[x]) + 6 * p2[x] + p4[x]);
+                derivative[x] = (int16_t)(p4[x] - p0[x] + 2 * (p3[x] - p1[x]));
+            }
+
+            const int16_t *s = smoothed.data();
+            const int16_t *d = derivative.data();
+            for (int x = 0; x < width; x++)
+            {
+                gradientX[x] = (int16_t)(s[x + 4] - s[x] + 2 * (s[x + 3] - s[x + 1]));
+                gradientY[x] = (int16_t)(d[x] + 4 * (d[x + 1] + d[x + 3]) + 6 * d[x + 2] + d[x + 4]);
+            }
+
+            if (magnitude)
+            {
+                uchar *magnitudeRow = magnitude->ptr<uchar>(y);
+                if (norm == GradientNorm::L1)
+                {
+                    for (int x = 0; x < width; x++)
+                    {
+                        magnitudeRow[x] = (uchar)min(abs(gradientX[x]) + abs(gradientY[x]), 255);
+                    }
+                }
+                else
+                {
+                    for (int x = 0; x < width; x++)
+                    {
+                        float squared = (float)gradientX[x] * gradientX[x] + (float)gradientY[x] * gradientY[x];
+                        magnitudeRow[x] = saturate_cast<uchar>(sqrt(squared));
+                    }
+                }
+            }
+
+            if (orientation)
+            {
+                uchar *orientationRow = orientation->ptr<uchar>(y);
+                for (int x = 0; x < width; x++)
+                {
+                    float angle = fastAtan2(gradientY[x], gradientX[x]);
+                    if (angle >= 180)
+                        angle -= 180;
+                    int bin = min((int)(angle * orientationBins / 180), orientationBins - 1);
+                    orientationRow[x] = (uchar)(bin * 180 / orientationBins);
+                }
+            }
+
+            if (dx)
+                copy(gradientX.begin(), gradientX.end(), dx->ptr<int16_t>(y));
+            if (dy)
+                copy(gradientY.begin(), gradientY.end(), dy->ptr<int16_t>(y));
+        } });
+}
+
+void sobelGradient(const Mat &gray, Mat &magnitude, GradientNorm norm, Mat *orientation, int orientationBins, Mat *dx, Mat *dy)
+{
+    sobelSweep(gray, &magnitude, norm, orientation, orientationBins, dx, dy);
+}
+
+void sobelDerivatives(const Mat &gray, Mat &dx, Mat &dy)
+{
+    sobelSweep(gray, nullptr, GradientNorm::L1, nullptr, 8, &dx, &dy);
+}
@@ -0,0 +1,29 @@
+#ifndef SOBEL_GRADIENT_H
+#define SOBEL_GRADIENT_H
+
+#include <opencv2/opencv.hpp>
+
+enum class GradientNorm
+{
+    // |dx| + |dy|
+    L1,
+    // sqrt(dx^2 + dy^2)
+    L2
+};
+
+// 5x5 Sobel derivatives of an 8 bit gray plane computed together in a single sweep: every row is
+// smoothed and differentiated vertically once, both horizontal passes read those two rows, and the
+// outputs are written from the signed 16 bit derivatives without intermediate images. Row bands
+// run in parallel.
+//
+// magnitude: 8 bit, saturated gradient norm
+// orientation: when not null, 8 bit direction of the gradient modulo 180 degrees quantised to
+//              orientationBins bins, as the first angle of the bin in degrees (which spans the
+//              0..180 hue of an 8 bit HSV image)
+// dx, dy: when not null, the CV_16SC1 derivatives, as cv::Canny takes them
+void sobelGradient(const cv::Mat &gray, cv::Mat &magnitude, GradientNorm norm = GradientNorm::L1,
+                   cv::Mat *orientation = nullptr, int orientationBins = 8, cv::Mat *dx = nullptr, cv::Mat *dy = nullptr);
+// Same sweep writing only the CV_16SC1 derivatives, for Canny which computes its own magnitude
+void sobelDerivatives(const cv::Mat &gray, cv::Mat &dx, cv::Mat &dy);
+
+#endif // SOBEL_GRADIENT_H
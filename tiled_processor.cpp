@@ -0,0 +1,328 @@
+#include "tiled_processor.h"
+#include "image_processing.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+using namespace cv;
+using namespace std;
+
+static bool isPnmPath(const string &path)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos)
+        return false;
+
+    string extension = path.substr(dot);
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".pgm" || extension == ".ppm" || extension == ".pnm";
+}
+
+// Next header token, skipping whitespace and # comments. The whitespace ending the last token
+// (maxval) is consumed too, so the pixels start right after it.
+static bool readPnmToken(istream &stream, string &token)
+{
+    token.clear();
+    int c;
+    while ((c = stream.get()) != EOF)
+    {
+        if (c == '#' && token.empty())
+        {
+            while ((c = stream.get()) != EOF && c != '\n')
+                ;
+            continue;
+        }
+        if (isspace(c))
+        {
+            if (!token.empty())
+                return true;
+            continue;
+        }
+        token += (char)c;
+    }
+    return !token.empty();
+}
+
+int operationHalo(const ImageOperation &operation)
+{
+    switch (operation.type)
+    {
+    case OperationType::ConvertToGray:
+    case OperationType::Negative:
+    case OperationType::BitSlicing:
+    case OperationType::AreaOfInterest:
+        return 0;
+    case OperationType::Segmentation:
+        // the automatic threshold is the mean of the whole image
+        return operation.values.empty() ? -1 : 0;
+    case OperationType::Flip:
+        // flip code 1 mirrors every row in place
+        return operation.option == 1 ? 0 : -1;
+    case OperationType::Median:
+        return (operation.values.empty() ? 3 : (int)operation.values.at(0)) / 2;
+    case OperationType::Sobel:
+        // 5x5 aperture
+        return 2;
+    case OperationType::LaplacianOfGaussian:
+        // zero crossings are scaled up from the coarser octaves of the whole image
+        return operation.values.empty() ? laplacianOfGaussianKernel().rows / 2 : -1;
+    case OperationType::Smoothing:
+        // every brush stroke reads the output of the previous ones, overlapping strokes reach
+        // one more kernel radius each
+        return smoothingKernel((SmoothingLevel)operation.option).rows / 2 * max<int>(1, operation.regions.size());
+    default:
+        return -1;
+    }
+}
+
+int operationsHalo(const vector<ImageOperation> &operations)
+{
+    int halo = 0;
+    for (const ImageOperation &operation : operations)
+    {
+        int operationRows = operationHalo(operation);
+        if (operationRows < 0)
+            return -1;
+        halo += operationRows;
+    }
+    return halo;
+}
+
+bool StripReader::open(const string &path, string &error)
+{
+    window.release();
+    windowStart = 0;
+    isStreamed = isPnmPath(path);
+
+    if (isStreamed)
+    {
+        file.open(path, ios::binary);
+        if (file && readPnmHeader(error))
+            return true;
+
+        // ASCII or 16 bit files, let imread deal with them
+        file.close();
+        isStreamed = false;
+    }
+
+    decoded = imread(path);
+    if (decoded.empty())
+    {
+        error = "failed to load the image " + path;
+        return false;
+    }
+
+    imageSize = decoded.size();
+    imageType = decoded.type();
+    return true;
+}
+
+bool StripReader::readPnmHeader(string &error)
+{
+    string magic, width, height, maxValue;
+    if (!readPnmToken(file, magic) || !readPnmToken(file, width) || !readPnmToken(file, height) || !readPnmToken(file, maxValue))
+    {
+        error = "invalid PNM header";
+        return false;
+    }
+
+    if ((magic != "P5" && magic != "P6") || atoi(maxValue.c_str()) > 255)
+    {
+        error = "only binary 8 bit PNM files are streamed";
+        return false;
+    }
+
+    imageSize = Size(atoi(width.c_str()), atoi(height.c_str()));
+    imageType = magic == "P5" ? CV_8UC1 : CV_8UC3;
+    return imageSize.area() > 0;
+}
+
+Size StripReader::size() const
+{
+    return imageSize;
+}
+
+int StripReader::type() const
+{
+    return imageType;
+}
+
+Mat StripReader::rows(int from, int to)
+{
+    if (!isStreamed)
+        return decoded.rowRange(from, to);
+
+    size_t rowBytes = (size_t)imageSize.width * CV_ELEM_SIZE(imageType);
+
+    // drop the rows above from, keeping only the halo overlap of the previous strip
+    int dropped = max(0, from - windowStart);
+    if (dropped >= window.rows)
+    {
+        // skip rows that were never read
+        file.ignore((streamsize)(dropped - window.rows) * rowBytes);
+        window.release();
+    }
+    else if (dropped > 0)
+    {
+        window = window.rowRange(dropped, window.rows).clone();
+    }
+    windowStart += dropped;
+
+    int windowEnd = windowStart + window.rows;
+    if (to > windowEnd)
+    {
+        Mat newRows(to - windowEnd, imageSize.width, imageType);
+        file.read((char *)newRows.data, newRows.rows * rowBytes);
+        if ((size_t)file.gcount() != newRows.rows * rowBytes)
+            return Mat();
+
+        // PPM stores RGB, imread returns BGR
+        if (newRows.channels() == 3)
+            cvtColor(newRows, newRows, COLOR_RGB2BGR);
+
+        if (window.empty())
+            window = newRows;
+        else
+            vconcat(window, newRows, window);
+    }
+
+    return window.rowRange(from - windowStart, to - windowStart);
+}
+
+bool StripWriter::open(const string &path, Size size, int type, string &error)
+{
+    this->path = path;
+    writtenRows = 0;
+    isStreamed = isPnmPath(path) && (type == CV_8UC1 || type == CV_8UC3);
+
+    if (!isStreamed)
+    {
+        collected.create(size, type);
+        return true;
+    }
+
+    file.open(path, ios::binary);
+    if (!file)
+    {
+        error = "failed to write " + path;
+        return false;
+    }
+
+    file << (type == CV_8UC1 ? "P5" : "P6") << "\n"
+         << size.width << " " << size.height << "\n255\n";
+    return true;
+}
+
+bool StripWriter::write(const Mat &strip)
+{
+    if (!isStreamed)
+    {
+        strip.copyTo(collected.rowRange(writtenRows, writtenRows + strip.rows));
+        writtenRows += strip.rows;
+        return true;
+    }
+
+    Mat pixels = strip;
+    if (strip.channels() == 3)
+        cvtColor(strip, pixels, COLOR_BGR2RGB);
+
+    for (int y = 0; y < pixels.rows; y++)
+    {
+        file.write((const char *)pixels.ptr(y), pixels.cols * pixels.elemSize());
+    }
+    writtenRows += strip.rows;
+    return (bool)file;
+}
+
+bool StripWriter::close(string &error)
+{
+    if (isStreamed)
+    {
+        file.close();
+        if (!file)
+        {
+            error = "failed to write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    bool saved = imwrite(path, collected);
+    collected.release();
+    if (!saved)
+        error = "failed to save the image " + path;
+    return saved;
+}
+
+// Regions are recorded in image coordinates, the strip starts at row top
+static ImageOperation operationInStrip(const ImageOperation &operation, int top)
+{
+    ImageOperation stripOperation = operation;
+    for (Rect &region : stripOperation.regions)
+    {
+        region.y -= top;
+    }
+    return stripOperation;
+}
+
+bool runTiled(const string &inputPath, const string &outputPath,
+              const vector<ImageOperation> &operations, const TiledOptions &options, string &error)
+{
+    for (const ImageOperation &operation : operations)
+    {
+        if (operationHalo(operation) < 0)
+        {
+            error = formatOperation(operation) + " needs the whole image and can't be processed in tiles";
+            return false;
+        }
+    }
+
+    StripReader reader;
+    if (!reader.open(inputPath, error))
+        return false;
+
+    int halo = operationsHalo(operations);
+    int tileRows = max(1, options.tileRows);
+    Size size = reader.size();
+    StripWriter writer;
+
+    try
+    {
+        for (int top = 0; top < size.height; top += tileRows)
+        {
+            int bottom = min(size.height, top + tileRows);
+
+            // the halo makes the rows of the tile exact, only the image border uses the border mode
+            int from = max(0, top - halo);
+            int to = min(size.height, bottom + halo);
+
+            Mat strip = reader.rows(from, to);
+            if (strip.empty())
+            {
+                error = "failed to read " + inputPath;
+                return false;
+            }
+
+            for (const ImageOperation &operation : operations)
+            {
+                strip = applyOperation(strip, operationInStrip(operation, from));
+            }
+
+            Mat tile = strip.rowRange(top - from, bottom - from);
+            if (top == 0 && !writer.open(outputPath, size, tile.type(), error))
+                return false;
+            if (!writer.write(tile))
+            {
+                error = "failed to write " + outputPath;
+                return false;
+            }
+        }
+    }
+    catch (const cv::Exception &exception)
+    {
+        error = exception.what();
+        return false;
+    }
+
+    return writer.close(error);
+}
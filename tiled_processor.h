@@ -0,0 +1,70 @@
+#ifndef TILED_PROCESSOR_H
+#define TILED_PROCESSOR_H
+
+#include "image_operation.h"
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct TiledOptions
+{
+    // rows processed at once, the window also holds the halo rows above and below
+    int tileRows = 512;
+};
+
+// Rows of context an operation needs above and below every output row, -1 when the
+// operation depends on the whole image (histogram, maximum, spectrum, geometry)
+int operationHalo(const ImageOperation &operation);
+// Sum of the halos, the operations are chained so each one widens the context of the previous
+int operationsHalo(const std::vector<ImageOperation> &operations);
+
+// Reads an image top to bottom. Binary PGM/PPM files are streamed from disk, other formats
+// are decoded at once by imread since their codecs don't expose partial decoding.
+class StripReader
+{
+public:
+    bool open(const std::string &path, std::string &error);
+    cv::Size size() const;
+    int type() const;
+
+    // Rows [from, to), from must not go back before the from of the previous call
+    cv::Mat rows(int from, int to);
+
+private:
+    bool readPnmHeader(std::string &error);
+
+    std::ifstream file;
+    cv::Mat decoded;
+    cv::Size imageSize;
+    int imageType = CV_8UC1;
+    bool isStreamed = false;
+
+    // rows [windowStart, windowStart + window.rows) read so far and still needed
+    cv::Mat window;
+    int windowStart = 0;
+};
+
+// Writes an image top to bottom. PGM/PPM output goes to disk strip by strip, other formats
+// are collected and encoded by imwrite on close.
+class StripWriter
+{
+public:
+    bool open(const std::string &path, cv::Size size, int type, std::string &error);
+    bool write(const cv::Mat &strip);
+    bool close(std::string &error);
+
+private:
+    std::string path;
+    std::ofstream file;
+    cv::Mat collected;
+    int writtenRows = 0;
+    bool isStreamed = false;
+};
+
+// Streams inputPath through the operations tile by tile so the peak memory is bounded by the tile
+// size, not the image size. Every operation must have a halo (see operationHalo).
+bool runTiled(const std::string &inputPath, const std::string &outputPath,
+              const std::vector<ImageOperation> &operations, const TiledOptions &options, std::string &error);
+
+#endif // TILED_PROCESSOR_H